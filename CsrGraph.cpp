@@ -0,0 +1,567 @@
+#include "CsrGraph.h"
+#include <stdint.h>
+#include <cstdio>
+
+// Binary snapshot layout: this header, then for each view in CsrViewId
+// order the int32 arrays offset[V+1], to[E], weight[E]
+struct SnapshotHeader{
+	char magic[8];		// "DSGSNAP" plus terminator
+	uint32_t version;	// Bumped whenever the layout changes
+	char type;		// 'L' or 'M', the format the graph was loaded from
+	char pad[3];
+	int64_t size;		// Number of vertices
+	int64_t edges[CSR_VIEWS];	// Entries in each view's to/weight arrays
+	uint64_t checksum;	// Hash of every array in the payload
+};
+
+static const char SNAPSHOT_MAGIC[8] = "DSGSNAP";
+static const uint32_t SNAPSHOT_VERSION = 2;
+
+// Spare room a row gets on top of doubling when it is moved to the tail
+static const int CSR_ROW_SLACK = 4;
+
+// Fold an int32 array into a running 64-bit hash
+static uint64_t hashInts(uint64_t h, const int* data, int64_t count)
+{
+	for (int64_t i = 0; i < count; i++) {
+		h = (h ^ (uint32_t)data[i]) * 0x100000001b3ULL;
+	}
+	return h;
+}
+
+// Transpose one view into dst; scanning sources in order keeps every
+// reversed list sorted by neighbor
+static void transposeView(const CsrView& src, int size, CsrStorage* dst)
+{
+	// Count entries per target, then prefix-sum into offsets
+	dst->offset.assign(size + 1, 0);
+	for (int i = 0; i < size; i++) {
+		for (int e = src.offset[i]; e < src.end[i]; e++) {
+			dst->offset[src.to[e] + 1]++;
+		}
+	}
+	for (int i = 0; i < size; i++) {
+		dst->offset[i + 1] += dst->offset[i];
+	}
+	
+	// Scatter every edge into its target's list
+	int edgeCount = dst->offset[size];
+	dst->to.resize(edgeCount);
+	dst->weight.resize(edgeCount);
+	vector<int> fill(dst->offset.begin(), dst->offset.end() - 1);
+	for (int i = 0; i < size; i++) {
+		for (int e = src.offset[i]; e < src.end[i]; e++) {
+			int pos = fill[src.to[e]]++;
+			dst->to[pos] = i;
+			dst->weight[pos] = src.weight[e];
+		}
+	}
+}
+
+// Give every row its own end and capacity, so updates can work in place
+static void openRows(CsrStorage* view)
+{
+	view->end.assign(view->offset.begin() + 1, view->offset.end());
+	view->limit = view->end;
+	view->unused = 0;
+}
+
+// Copy the live part of every row back into packed arrays
+static void packRows(CsrStorage* view, int size)
+{
+	if (view->end.empty())
+		return;
+	
+	vector<int> offset(size + 1, 0);
+	vector<int> to, weight;
+	to.reserve(view->to.size() - view->unused);
+	weight.reserve(view->to.size() - view->unused);
+	for (int i = 0; i < size; i++) {
+		to.insert(to.end(), view->to.begin() + view->offset[i], view->to.begin() + view->end[i]);
+		weight.insert(weight.end(), view->weight.begin() + view->offset[i], view->weight.begin() + view->end[i]);
+		offset[i + 1] = (int)to.size();
+	}
+	
+	view->offset.swap(offset);
+	view->to.swap(to);
+	view->weight.swap(weight);
+	view->end.clear();
+	view->limit.clear();
+	view->unused = 0;
+}
+
+CsrGraph::CsrGraph(Graph* source) : Graph(source->getType(), source->getSize())
+{
+	m_Snapshot = nullptr;
+	CsrStorage& out = m_Store[CSR_OUT];
+	
+	// Flatten the outgoing edges of every vertex into contiguous arrays
+	out.offset.assign(m_Size + 1, 0);
+	for (int i = 0; i < m_Size; i++) {
+		EdgeSpan edges = source->getNeighbors(i, true);
+		
+		for (int k = 0; k < edges.count; k++) {
+			out.to.push_back(edges.to[k]);
+			out.weight.push_back(edges.weight[k]);
+		}
+		out.offset[i + 1] = (int)out.to.size();
+	}
+	
+	buildDerived();
+}
+
+CsrGraph::CsrGraph(const EdgeList& edges) : Graph(true, edges.size)
+{
+	m_Snapshot = nullptr;
+	CsrStorage& out = m_Store[CSR_OUT];
+	
+	int edgeCount = (int)edges.from.size();
+	
+	// Count edges per source vertex, then prefix-sum into offsets
+	vector<int> offset(m_Size + 1, 0);
+	for (int e = 0; e < edgeCount; e++) {
+		offset[edges.from[e] + 1]++;
+	}
+	for (int i = 0; i < m_Size; i++) {
+		offset[i + 1] += offset[i];
+	}
+	
+	// Scatter edges by source; file order is kept inside each vertex
+	vector<int> to(edgeCount);
+	vector<int> weight(edgeCount);
+	vector<int> fill(offset.begin(), offset.end() - 1);
+	for (int e = 0; e < edgeCount; e++) {
+		int pos = fill[edges.from[e]]++;
+		to[pos] = edges.to[e];
+		weight[pos] = edges.weight[e];
+	}
+	
+	// Sort each vertex's edges by target; a repeated target keeps the
+	// weight listed last, the same as repeated insertEdge calls
+	out.offset.assign(m_Size + 1, 0);
+	out.to.reserve(edgeCount);
+	out.weight.reserve(edgeCount);
+	vector<int> order;
+	for (int i = 0; i < m_Size; i++) {
+		int begin = offset[i], end = offset[i + 1];
+		
+		order.clear();
+		for (int e = begin; e < end; e++) {
+			order.push_back(e);
+		}
+		if (!is_sorted(to.begin() + begin, to.begin() + end)) {
+			stable_sort(order.begin(), order.end(), [&](int a, int b) { return to[a] < to[b]; });
+		}
+		
+		for (size_t k = 0; k < order.size(); k++) {
+			int e = order[k];
+			if (k + 1 < order.size() && to[order[k + 1]] == to[e])
+				continue;	// A later duplicate overrides this one
+			out.to.push_back(to[e]);
+			out.weight.push_back(weight[e]);
+		}
+		out.offset[i + 1] = (int)out.to.size();
+	}
+	
+	buildDerived();
+}
+
+CsrGraph::CsrGraph(int size, GraphFile* snapshot) : Graph(true, size)
+{
+	// Views are pointed into the mapping by openSnapshot
+	m_Snapshot = snapshot;
+}
+
+CsrGraph::~CsrGraph()
+{
+	// Release the snapshot mapping if the views still use it
+	if (m_Snapshot)
+		delete m_Snapshot;
+}
+
+void CsrGraph::bindStorage()
+{
+	// Point the views at the owned vectors
+	for (int v = 0; v < CSR_VIEWS; v++) {
+		m_View[v].offset = m_Store[v].offset.data();
+		m_View[v].end = m_Store[v].end.empty() ? m_View[v].offset + 1 : m_Store[v].end.data();
+		m_View[v].to = m_Store[v].to.data();
+		m_View[v].weight = m_Store[v].weight.data();
+	}
+}
+
+void CsrGraph::detachSnapshot()
+{
+	// Copy mapped arrays into owned storage before the graph is modified
+	if (!m_Snapshot)
+		return;
+	
+	for (int v = 0; v < CSR_VIEWS; v++) {
+		const CsrView& view = m_View[v];
+		int edgeCount = view.offset[m_Size];
+		m_Store[v].offset.assign(view.offset, view.offset + m_Size + 1);
+		m_Store[v].to.assign(view.to, view.to + edgeCount);
+		m_Store[v].weight.assign(view.weight, view.weight + edgeCount);
+	}
+	bindStorage();
+	
+	delete m_Snapshot;
+	m_Snapshot = nullptr;
+}
+
+void CsrGraph::packStorage()
+{
+	// Drop the slack left by updates; a mapped snapshot is packed already
+	if (m_Snapshot)
+		return;
+	
+	for (int v = 0; v < CSR_VIEWS; v++) {
+		packRows(&m_Store[v], m_Size);
+	}
+	bindStorage();
+}
+
+void CsrGraph::buildDerived()
+{
+	// Everything below is derived from the outgoing edges
+	const CsrStorage& out = m_Store[CSR_OUT];
+	const CsrStorage& in = m_Store[CSR_IN];
+	CsrStorage& und = m_Store[CSR_UND];
+	bindStorage();
+	
+	transposeView(m_View[CSR_OUT], m_Size, &m_Store[CSR_IN]);
+	
+	// Merge outgoing and incoming lists per vertex.
+	// An incoming edge overrides the outgoing one to the same neighbor,
+	// matching ListGraph/MatrixGraph::getAdjacentEdges.
+	int edgeCount = (int)out.to.size();
+	und.offset.assign(m_Size + 1, 0);
+	und.to.clear();
+	und.weight.clear();
+	und.to.reserve(2 * edgeCount);
+	und.weight.reserve(2 * edgeCount);
+	for (int v = 0; v < m_Size; v++) {
+		int a = out.offset[v], aEnd = out.offset[v + 1];
+		int b = in.offset[v], bEnd = in.offset[v + 1];
+		
+		while (a < aEnd || b < bEnd) {
+			// Self loops only come from the outgoing list
+			if (b < bEnd && in.to[b] == v) {
+				b++;
+				continue;
+			}
+			if (b == bEnd || (a < aEnd && out.to[a] < in.to[b])) {
+				und.to.push_back(out.to[a]);
+				und.weight.push_back(out.weight[a]);
+				a++;
+			} else {
+				if (a < aEnd && out.to[a] == in.to[b])
+					a++;
+				und.to.push_back(in.to[b]);
+				und.weight.push_back(in.weight[b]);
+				b++;
+			}
+		}
+		und.offset[v + 1] = (int)und.to.size();
+	}
+	
+	// Undirected weights are not always symmetric, so its reverse is separate
+	bindStorage();
+	transposeView(m_View[CSR_UND], m_Size, &m_Store[CSR_UND_REV]);
+	
+	// Vectors may have moved, so refresh the views
+	bindStorage();
+}
+
+void CsrGraph::getAdjacentEdges(int vertex, map<int, int>* m)	 
+{
+	// Copy the undirected neighbor range into the map
+	EdgeSpan edges = span(CSR_UND, vertex);
+	m->clear();
+	for (int k = 0; k < edges.count; k++) {
+		(*m)[edges.to[k]] = edges.weight[k];
+	}
+}
+
+void CsrGraph::getAdjacentEdgesDirect(int vertex, map<int, int>* m)	
+{
+	// Copy the outgoing neighbor range into the map
+	EdgeSpan edges = span(CSR_OUT, vertex);
+	m->clear();
+	for (int k = 0; k < edges.count; k++) {
+		(*m)[edges.to[k]] = edges.weight[k];
+	}
+}
+
+void CsrGraph::insertEdge(int from, int to, int weight) 
+{
+	// Overwrites the weight if the edge exists
+	setEdge(from, to, true, weight);
+}
+
+bool CsrGraph::deleteEdge(int from, int to)
+{
+	int weight;
+	if (!findEdge(from, to, true, &weight))
+		return false;
+	setEdge(from, to, false, 0);
+	return true;
+}
+
+void CsrGraph::patchView(CsrViewId id, int row, int col, bool present, int weight)
+{
+	// Set or remove (row, col) inside the row, keeping it sorted. Only
+	// this row's entries move, so an update is O(degree) amortized.
+	CsrStorage& view = m_Store[id];
+	if (view.end.empty())
+		openRows(&view);
+	int begin = view.offset[row], end = view.end[row];
+	int pos = (int)(lower_bound(view.to.begin() + begin, view.to.begin() + end, col) - view.to.begin());
+	bool found = (pos < end && view.to[pos] == col);
+	
+	if (present && found) {
+		view.weight[pos] = weight;
+	} else if (present) {
+		// A full row moves to the tail with twice the room it had
+		if (end == view.limit[row]) {
+			int count = end - begin;
+			int capacity = 2 * count + CSR_ROW_SLACK;
+			int start = (int)view.to.size();
+			view.to.resize(start + capacity);
+			view.weight.resize(start + capacity);
+			copy(view.to.begin() + begin, view.to.begin() + end, view.to.begin() + start);
+			copy(view.weight.begin() + begin, view.weight.begin() + end, view.weight.begin() + start);
+			view.offset[row] = start;
+			view.limit[row] = start + capacity;
+			view.unused += capacity;
+			pos += start - begin;
+			end = start + count;
+		}
+		copy_backward(view.to.begin() + pos, view.to.begin() + end, view.to.begin() + end + 1);
+		copy_backward(view.weight.begin() + pos, view.weight.begin() + end, view.weight.begin() + end + 1);
+		view.to[pos] = col;
+		view.weight[pos] = weight;
+		view.end[row] = end + 1;
+		view.unused--;
+	} else if (found) {
+		copy(view.to.begin() + pos + 1, view.to.begin() + end, view.to.begin() + pos);
+		copy(view.weight.begin() + pos + 1, view.weight.begin() + end, view.weight.begin() + pos);
+		view.end[row] = end - 1;
+		view.unused++;
+	}
+	
+	// Repack once dead slots outnumber the live ones; the O(E + V) pass
+	// is paid for by the updates that left them behind
+	if (view.unused > (int)view.to.size() - view.unused + m_Size)
+		packRows(&view, m_Size);
+}
+
+void CsrGraph::setEdge(int from, int to, bool present, int weight)
+{
+	// A mapped snapshot is read-only, switch to owned storage first
+	detachSnapshot();
+	
+	patchView(CSR_OUT, from, to, present, weight);
+	patchView(CSR_IN, to, from, present, weight);
+	bindStorage();
+	
+	// Only the undirected entries between from and to can change; they are
+	// redone from the outgoing edges with the merge rule of buildDerived
+	int forward, backward;
+	bool hasForward = findEdge(from, to, true, &forward);
+	bool hasBackward = findEdge(to, from, true, &backward);
+	if (from == to) {
+		patchView(CSR_UND, from, from, hasForward, forward);
+		patchView(CSR_UND_REV, from, from, hasForward, forward);
+	} else {
+		// An incoming edge overrides the outgoing one to the same neighbor
+		bool present = hasForward || hasBackward;
+		int fromSide = hasBackward ? backward : forward;	// Entry (from, to)
+		int toSide = hasForward ? forward : backward;		// Entry (to, from)
+		patchView(CSR_UND, from, to, present, fromSide);
+		patchView(CSR_UND, to, from, present, toSide);
+		patchView(CSR_UND_REV, to, from, present, fromSide);
+		patchView(CSR_UND_REV, from, to, present, toSide);
+	}
+	
+	// Vectors may have moved, so refresh the views
+	bindStorage();
+}
+
+bool CsrGraph::printGraph(ostream *fout)	
+{
+	// Check if graph exists
+	if (m_Size <= 0)
+		return false;
+	
+	// Print adjacency list format
+	for (int i = 0; i < m_Size; i++) {
+		*fout << "[" << i << "]";
+		EdgeSpan edges = span(CSR_OUT, i);
+		for (int k = 0; k < edges.count; k++) {
+			*fout << " -> (" << edges.to[k] << "," << edges.weight[k] << ")";
+		}
+		*fout << '\n';
+	}
+	
+	return true;
+}
+
+EdgeSpan CsrGraph::span(CsrViewId id, int vertex)
+{
+	// Point straight into the flat arrays, nothing is copied
+	const CsrView& view = m_View[id];
+	EdgeSpan edges;
+	edges.to = view.to + view.offset[vertex];
+	edges.weight = view.weight + view.offset[vertex];
+	edges.count = view.end[vertex] - view.offset[vertex];
+	return edges;
+}
+
+EdgeSpan CsrGraph::getNeighbors(int vertex, bool direct)
+{
+	return span(direct ? CSR_OUT : CSR_UND, vertex);
+}
+
+EdgeSpan CsrGraph::getReverseNeighbors(int vertex, bool direct)
+{
+	return span(direct ? CSR_IN : CSR_UND_REV, vertex);
+}
+
+bool CsrGraph::hasStableSpans()
+{
+	// Spans point into storage that only insertEdge/deleteEdge/SAVE change
+	return true;
+}
+
+int CsrGraph::getEdgeCount()
+{
+	const CsrStorage& out = m_Store[CSR_OUT];
+	if (out.end.empty())
+		return m_View[CSR_OUT].offset[m_Size];
+	return (int)out.to.size() - out.unused;
+}
+
+bool CsrGraph::saveSnapshot(const char* filename, char type)
+{
+	// The views may be mapped from the very file being replaced, and
+	// truncating it would pull the pages out from under them. Write a
+	// temporary file next to it and rename it over the target instead;
+	// the mapping keeps the old file alive until it is closed.
+	string temp = string(filename) + ".tmp";
+	packStorage();
+	ofstream out(temp.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!out)
+		return false;
+	
+	// Fill in the header, hashing the arrays in payload order
+	SnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SNAPSHOT_VERSION;
+	header.type = type;
+	header.size = m_Size;
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (int v = 0; v < CSR_VIEWS; v++) {
+		const CsrView& view = m_View[v];
+		header.edges[v] = view.offset[m_Size];
+		h = hashInts(h, view.offset, m_Size + 1);
+		h = hashInts(h, view.to, header.edges[v]);
+		h = hashInts(h, view.weight, header.edges[v]);
+	}
+	header.checksum = h;
+	
+	// Write header and arrays back to back
+	out.write((const char*)&header, sizeof(header));
+	for (int v = 0; v < CSR_VIEWS; v++) {
+		const CsrView& view = m_View[v];
+		out.write((const char*)view.offset, (m_Size + 1) * sizeof(int));
+		out.write((const char*)view.to, header.edges[v] * sizeof(int));
+		out.write((const char*)view.weight, header.edges[v] * sizeof(int));
+	}
+	out.close();
+	if (out.fail() || rename(temp.c_str(), filename) != 0) {
+		remove(temp.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool CsrGraph::isSnapshot(GraphFile* file)
+{
+	// Text graph files can never start with the magic bytes
+	return file->getBytes() >= sizeof(SnapshotHeader)
+		&& memcmp(file->getData(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+}
+
+CsrGraph* CsrGraph::openSnapshot(GraphFile* file, char* type, bool verify)
+{
+	// Check the header before trusting any of the sizes in it
+	if (!isSnapshot(file))
+		return nullptr;
+	SnapshotHeader header;
+	memcpy(&header, file->getData(), sizeof(header));
+	if (header.version != SNAPSHOT_VERSION || (header.type != 'L' && header.type != 'M'))
+		return nullptr;
+	if (header.size < 0 || header.size > INT32_MAX)
+		return nullptr;
+	int64_t ints = 0;
+	for (int v = 0; v < CSR_VIEWS; v++) {
+		if (header.edges[v] < 0 || header.edges[v] > INT32_MAX)
+			return nullptr;
+		ints += header.size + 1 + 2 * header.edges[v];
+	}
+	if (file->getBytes() != sizeof(header) + ints * sizeof(int))
+		return nullptr;
+	
+	// Lay the views over the mapped payload
+	int size = (int)header.size;
+	const int* p = (const int*)(file->getData() + sizeof(header));
+	CsrView views[CSR_VIEWS];
+	for (int v = 0; v < CSR_VIEWS; v++) {
+		views[v].offset = p;
+		views[v].end = p + 1;
+		views[v].to = views[v].offset + size + 1;
+		views[v].weight = views[v].to + header.edges[v];
+		p = views[v].weight + header.edges[v];
+	}
+	
+	// Offsets are checked on every load, which is O(V) and keeps each
+	// row inside its view. The O(E) pass over the payload only runs when
+	// asked for; otherwise the arrays are trusted as SAVE wrote them.
+	for (int v = 0; v < CSR_VIEWS; v++) {
+		const CsrView& view = views[v];
+		if (view.offset[0] != 0 || view.offset[size] != header.edges[v])
+			return nullptr;
+		for (int i = 0; i < size; i++) {
+			if (view.offset[i] > view.offset[i + 1])
+				return nullptr;
+		}
+	}
+	if (verify) {
+		// Checksum, then every row strictly ascending and in range, as
+		// the algorithms and patchView expect
+		uint64_t h = hashInts(0xcbf29ce484222325ULL, (const int*)(file->getData() + sizeof(header)), ints);
+		if (h != header.checksum)
+			return nullptr;
+		for (int v = 0; v < CSR_VIEWS; v++) {
+			const CsrView& view = views[v];
+			for (int i = 0; i < size; i++) {
+				for (int e = view.offset[i]; e < view.offset[i + 1]; e++) {
+					if (view.to[e] < 0 || view.to[e] >= size)
+						return nullptr;
+					if (e > view.offset[i] && view.to[e] <= view.to[e - 1])
+						return nullptr;
+				}
+			}
+		}
+	}
+	
+	// The graph takes over the mapping and reads it in place
+	CsrGraph* graph = new CsrGraph(size, file);
+	for (int v = 0; v < CSR_VIEWS; v++) {
+		graph->m_View[v] = views[v];
+	}
+	*type = header.type;
+	return graph;
+}
\ No newline at end of file
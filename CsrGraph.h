@@ -0,0 +1,72 @@
+#ifndef _CSR_H_
+#define _CSR_H_
+
+#include "Graph.h"
+#include "GraphLoader.h"
+
+// One adjacency layout: neighbors of v live in [offset[v], end[v])
+struct CsrView{
+	const int* offset;
+	const int* end;		// offset + 1 while the rows are packed
+	const int* to;
+	const int* weight;
+};
+
+// Owned arrays behind a CsrView. Rows start packed; the first update
+// gives every row its own end and capacity so later ones work in place.
+struct CsrStorage{
+	vector<int> offset;
+	vector<int> to;
+	vector<int> weight;
+	vector<int> end;	// Row ends, empty while packed
+	vector<int> limit;	// Row capacity ends, empty while packed
+	int unused;		// Slots of to/weight holding no edge
+	
+	CsrStorage() : unused(0) {}
+};
+
+// Adjacency views kept by CsrGraph
+enum CsrViewId{
+	CSR_OUT,	// Outgoing edges
+	CSR_IN,		// Incoming edges (reverse of CSR_OUT)
+	CSR_UND,	// Undirected view: outgoing plus incoming edges
+	CSR_UND_REV,	// Reverse of the undirected view
+	CSR_VIEWS
+};
+
+class CsrGraph : public Graph{	
+private:
+	CsrStorage m_Store[CSR_VIEWS];	// Owned storage for every view
+	CsrView m_View[CSR_VIEWS];	// Views into m_Store or a snapshot mapping
+	GraphFile* m_Snapshot;		// Mapping behind the views, nullptr when owned
+
+	CsrGraph(int size, GraphFile* snapshot);
+	void buildDerived();
+	void bindStorage();
+	void detachSnapshot();
+	void packStorage();
+	EdgeSpan span(CsrViewId id, int vertex);
+	void patchView(CsrViewId id, int row, int col, bool present, int weight);
+	void setEdge(int from, int to, bool present, int weight);
+
+public:	
+	CsrGraph(Graph* source);
+	CsrGraph(const EdgeList& edges);
+	~CsrGraph();
+		
+	void getAdjacentEdges(int vertex, map<int, int>* m);	
+	void getAdjacentEdgesDirect(int vertex, map<int, int>* m);
+	void insertEdge(int from, int to, int weight);	
+	bool deleteEdge(int from, int to);
+	bool printGraph(ostream *fout);
+	EdgeSpan getNeighbors(int vertex, bool direct);
+	EdgeSpan getReverseNeighbors(int vertex, bool direct);
+	bool hasStableSpans();
+	int getEdgeCount();
+
+	bool saveSnapshot(const char* filename, char type);
+	static bool isSnapshot(GraphFile* file);
+	static CsrGraph* openSnapshot(GraphFile* file, char* type, bool verify);	// verify: O(E) checks
+};
+
+#endif
\ No newline at end of file
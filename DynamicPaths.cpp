@@ -0,0 +1,300 @@
+#include "DynamicPaths.h"
+#include "IndexedHeap.h"
+#include "FloydKernel.h"
+#include "Metrics.h"
+#include "ScratchArena.h"
+#include <climits>
+#include <algorithm>
+
+// Record one view entry with its current weight
+static void watchEntry(Graph* graph, bool direct, int from, int to, vector<EdgeChange>& changes)
+{
+	EdgeChange change;
+	change.from = from;
+	change.to = to;
+	change.oldWeight = 0;
+	change.had = graph->findEdge(from, to, direct, &change.oldWeight);
+	change.has = false;
+	change.newWeight = 0;
+	changes.push_back(change);
+}
+
+void watchEdge(Graph* graph, int from, int to, vector<EdgeChange> changes[2])
+{
+	changes[0].clear();
+	changes[1].clear();
+	watchEntry(graph, true, from, to, changes[1]);
+	watchEntry(graph, false, from, to, changes[0]);
+	if (from != to)
+		watchEntry(graph, false, to, from, changes[0]);
+}
+
+void settleEdge(Graph* graph, vector<EdgeChange> changes[2])
+{
+	for (int view = 0; view < 2; view++) {
+		vector<EdgeChange>& list = changes[view];
+		size_t kept = 0;
+		for (size_t i = 0; i < list.size(); i++) {
+			EdgeChange change = list[i];
+			change.has = graph->findEdge(change.from, change.to, view == 1, &change.newWeight);
+
+			// An undirected entry may be covered by the other direction's edge
+			if (change.had == change.has && (!change.has || change.oldWeight == change.newWeight))
+				continue;
+			list[kept++] = change;
+		}
+		list.resize(kept);
+	}
+}
+
+bool updateDijkstraTree(Graph* graph, bool direct, int source, const vector<EdgeChange>& changes,
+	const WeightProfile& profile, vector<int>* distOut, vector<int>* prevOut)
+{
+	// With weights of at least 1 Dijkstra settles vertices in (distance,
+	// vertex) order, so a parent is the tight in-neighbor with the smallest
+	// (distance, vertex). Zero weights let the order depend on more than that.
+	if (profile.edges > 0 && profile.minWeight < 1)
+		return false;
+
+	int size = graph->getSize();
+	vector<int>& dist = *distOut;
+	vector<int>& prev = *prevOut;
+	if ((int)dist.size() != size || (int)prev.size() != size)
+		return false;
+	ScratchScope scratch;
+
+	// Only vertices under a tree edge that got longer or went away can lose
+	// distance; every other vertex keeps a tree path of the same length
+	vector<int> roots;
+	for (size_t i = 0; i < changes.size(); i++) {
+		const EdgeChange& c = changes[i];
+		if (c.had && (!c.has || c.newWeight > c.oldWeight) && c.from != c.to && prev[c.to] == c.from)
+			roots.push_back(c.to);
+	}
+	// Each list below holds a vertex at most once
+	char* affected = scratch.take<char>(size, 0);
+	int* lost = scratch.take<int>(size);
+	int lostCount = 0;
+	if (!roots.empty()) {
+		ScratchScope grouping;
+		// Children grouped by parent with a counting sort
+		int* start = grouping.take<int>(size + 1, 0);
+		for (int v = 0; v < size; v++) {
+			if (prev[v] >= 0) start[prev[v] + 1]++;
+		}
+		for (int v = 0; v < size; v++) start[v + 1] += start[v];
+		int* child = grouping.take<int>(start[size]);
+		int* fillAt = grouping.take<int>(size);
+		copy(start, start + size, fillAt);
+		for (int v = 0; v < size; v++) {
+			if (prev[v] >= 0) child[fillAt[prev[v]]++] = v;
+		}
+
+		// Every subtree, read off in one pass over a growing list
+		for (size_t r = 0; r < roots.size(); r++) {
+			if (affected[roots[r]]) continue;
+			affected[roots[r]] = 1;
+			lost[lostCount++] = roots[r];
+		}
+		for (int i = 0; i < lostCount; i++) {
+			int v = lost[i];
+			for (int k = start[v]; k < start[v + 1]; k++) {
+				if (!affected[child[k]]) {
+					affected[child[k]] = 1;
+					lost[lostCount++] = child[k];
+				}
+			}
+		}
+	}
+
+	static thread_local IndexedHeap heap;
+	heap.reset(size);
+	char* changed = scratch.take<char>(size, 0);
+	int* changedList = scratch.take<int>(size);
+	copy(lost, lost + lostCount, changedList);
+	int changedCount = lostCount;
+	long long scanned = 0;
+
+	// Lost vertices restart from the edges coming in from the rest of the tree
+	for (int i = 0; i < lostCount; i++) {
+		dist[lost[i]] = INT_MAX;
+		changed[lost[i]] = 1;
+	}
+	for (int i = 0; i < lostCount; i++) {
+		int x = lost[i];
+		EdgeSpan edges = graph->getReverseNeighbors(x, direct);
+		scanned += edges.count;
+		for (int k = 0; k < edges.count; k++) {
+			int y = edges.to[k];
+			if (affected[y] || dist[y] == INT_MAX) continue;
+			if (dist[y] + edges.weight[k] < dist[x])
+				dist[x] = dist[y] + edges.weight[k];
+		}
+		if (dist[x] != INT_MAX)
+			heap.push(x, dist[x]);
+	}
+
+	// Lowered or added edges leaving a vertex that kept its distance
+	for (size_t i = 0; i < changes.size(); i++) {
+		const EdgeChange& c = changes[i];
+		if (!c.has || c.from == c.to || affected[c.from] || dist[c.from] == INT_MAX)
+			continue;
+		if (dist[c.from] + c.newWeight < dist[c.to]) {
+			dist[c.to] = dist[c.from] + c.newWeight;
+			heap.push(c.to, dist[c.to]);
+			if (!changed[c.to]) {
+				changed[c.to] = 1;
+				changedList[changedCount++] = c.to;
+			}
+		}
+	}
+
+	// Dijkstra from everything queued; the rest of the tree is already final
+	while (!heap.empty()) {
+		long long d;
+		int curr = heap.pop(&d);
+		EdgeSpan edges = graph->getNeighbors(curr, direct);
+		scanned += edges.count;
+		for (int k = 0; k < edges.count; k++) {
+			int next = edges.to[k];
+			if (dist[curr] + edges.weight[k] < dist[next]) {
+				dist[next] = dist[curr] + edges.weight[k];
+				heap.push(next, dist[next]);
+				if (!changed[next]) {
+					changed[next] = 1;
+					changedList[changedCount++] = next;
+				}
+			}
+		}
+	}
+
+	// A parent can only change at a changed distance, one edge past one,
+	// or at the head of a changed entry
+	char* redo = scratch.take<char>(size, 0);
+	int* redoList = scratch.take<int>(size);
+	int redoCount = 0;
+	for (int i = 0; i < changedCount; i++) {
+		int v = changedList[i];
+		if (!redo[v]) {
+			redo[v] = 1;
+			redoList[redoCount++] = v;
+		}
+		EdgeSpan edges = graph->getNeighbors(v, direct);
+		for (int k = 0; k < edges.count; k++) {
+			if (!redo[edges.to[k]]) {
+				redo[edges.to[k]] = 1;
+				redoList[redoCount++] = edges.to[k];
+			}
+		}
+	}
+	for (size_t i = 0; i < changes.size(); i++) {
+		if (!redo[changes[i].to]) {
+			redo[changes[i].to] = 1;
+			redoList[redoCount++] = changes[i].to;
+		}
+	}
+	for (int i = 0; i < redoCount; i++) {
+		int x = redoList[i];
+		prev[x] = -1;
+		if (x == source || dist[x] == INT_MAX) continue;
+		EdgeSpan edges = graph->getReverseNeighbors(x, direct);
+		scanned += edges.count;
+		for (int k = 0; k < edges.count; k++) {
+			int y = edges.to[k];
+			if (y == x || dist[y] == INT_MAX || dist[y] + edges.weight[k] != dist[x]) continue;
+			if (prev[x] == -1 || dist[y] < dist[prev[x]] || (dist[y] == dist[prev[x]] && y < prev[x]))
+				prev[x] = y;
+		}
+	}
+
+	HeapStats stats = heap.getStats();
+	countWork(changedCount, scanned, stats.pushes, stats.pushes + stats.decreaseKeys);
+	return true;
+}
+
+bool updateAllPairs(int size, const vector<EdgeChange>& changes, vector<int>* distOut, bool* ok,
+	ThreadPool* pool)
+{
+	vector<int>& dist = *distOut;
+
+	// A raised or removed entry can lengthen any path through it
+	for (size_t i = 0; i < changes.size(); i++) {
+		const EdgeChange& c = changes[i];
+		if (c.had && (!c.has || c.newWeight > c.oldWeight))
+			return false;
+	}
+
+	// A negative cycle stays one while entries only go down
+	if (!*ok)
+		return true;
+	if (dist.size() != (size_t)size * size)
+		return false;
+
+	for (size_t i = 0; i < changes.size(); i++) {
+		int a = changes[i].from, b = changes[i].to;
+		long long w = changes[i].newWeight;
+		int* diagonal = &dist[(size_t)a * size + a];
+
+		if (a == b) {
+			// A self-loop only shows on its own diagonal, which Floyd starts
+			// from the loop's weight: the shortest cycle through a
+			long long cycle = w;
+			if (changes[i].had) {
+				cycle = min<long long>(cycle, *diagonal);
+			} else {
+				for (int k = 0; k < size; k++) {
+					int out = dist[(size_t)a * size + k], in = dist[(size_t)k * size + a];
+					if (k != a && out != FLOYD_INF && in != FLOYD_INF)
+						cycle = min(cycle, (long long)out + in);
+				}
+			}
+			*diagonal = (int)cycle;
+			countWork(1, 0, 0, size);
+		} else {
+			int current = dist[(size_t)a * size + b];
+			if (current != FLOYD_INF && current <= w) continue;
+
+			// Distances into a and out of b before the update; a path may
+			// start at a or end at b, so those two are 0 instead of the diagonal
+			ScratchScope scratch;
+			long long* toA = scratch.take<long long>(size);
+			long long* fromB = scratch.take<long long>(size);
+			for (int v = 0; v < size; v++) {
+				int in = dist[(size_t)v * size + a], out = dist[(size_t)b * size + v];
+				toA[v] = (v == a) ? 0 : (in == FLOYD_INF ? LLONG_MAX : in);
+				fromB[v] = (v == b) ? 0 : (out == FLOYD_INF ? LLONG_MAX : out);
+			}
+
+			// Rows are independent, so blocks of them are split across the pool
+			const int BLOCK = 64;
+			function<void(int)> relaxRows = [&](int block) {
+				int last = min(size, (block + 1) * BLOCK);
+				for (int r = block * BLOCK; r < last; r++) {
+					if (toA[r] == LLONG_MAX) continue;
+					long long base = toA[r] + w;
+					int* row = &dist[(size_t)r * size];
+					for (int j = 0; j < size; j++) {
+						if (fromB[j] != LLONG_MAX && base + fromB[j] < row[j])
+							row[j] = (int)(base + fromB[j]);
+					}
+				}
+			};
+			int blocks = (size + BLOCK - 1) / BLOCK;
+			if (pool) {
+				pool->parallelFor(blocks, relaxRows);
+			} else {
+				for (int block = 0; block < blocks; block++) relaxRows(block);
+			}
+			countWork(size, 1, 0, (long long)size * size);
+		}
+
+		// A new negative cycle makes FLOYD fail, as it would from scratch
+		for (int v = 0; v < size; v++) {
+			if (dist[(size_t)v * size + v] < 0) {
+				*ok = false;
+				return true;
+			}
+		}
+	}
+	return true;
+}
\ No newline at end of file
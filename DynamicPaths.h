@@ -0,0 +1,39 @@
+#ifndef _DYNAMICPATHS_H_
+#define _DYNAMICPATHS_H_
+
+#include "Graph.h"
+#include "ThreadPool.h"
+#include "SparsePaths.h"
+
+// One entry of an adjacency view that an edge update changed
+struct EdgeChange{
+	int from;
+	int to;
+	bool had;	// The entry existed before, with oldWeight
+	bool has;	// The entry exists now, with newWeight
+	int oldWeight;
+	int newWeight;
+};
+
+// An update of edge from -> to changes entry (from, to) of the directed
+// view, and (from, to) and (to, from) of the undirected one. Call
+// watchEdge before the update and settleEdge after it; changes[1] then
+// holds the directed view's changed entries and changes[0] the undirected's.
+void watchEdge(Graph* graph, int from, int to, vector<EdgeChange> changes[2]);
+void settleEdge(Graph* graph, vector<EdgeChange> changes[2]);
+
+// Bring a Dijkstra tree up to date after changes to its view: distances
+// under a raised or removed tree edge are recomputed from the rest of the
+// tree, lowered or added edges are propagated, and only vertices near a
+// changed distance get a new parent. False when the tree has to be
+// recomputed instead, which is when some weight is below 1.
+bool updateDijkstraTree(Graph* graph, bool direct, int source, const vector<EdgeChange>& changes,
+	const WeightProfile& profile, vector<int>* dist, vector<int>* prev);
+
+// Fold lowered or added entries into a FLOYD matrix at O(V^2) each,
+// d(i, j) = min(d(i, j), d(i, a) + w + d(b, j)). False when an entry was
+// raised or removed, which needs a full recompute.
+bool updateAllPairs(int size, const vector<EdgeChange>& changes, vector<int>* dist, bool* ok,
+	ThreadPool* pool);
+
+#endif
\ No newline at end of file
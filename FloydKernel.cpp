@@ -0,0 +1,174 @@
+#include "FloydKernel.h"
+#include <algorithm>
+#include <unistd.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+// dist_i[j] = min(dist_i[j], dik + dist_k[j]) over j in [0, len).
+// Entries of dist_k equal to FLOYD_INF are masked out, and a sum past the
+// int range saturates: above it the path is no better than FLOYD_INF and
+// is dropped, below it the distance sticks at INT_MIN.
+static void relaxRowScalar(int* di, const int* dk, int dik, int len)
+{
+	if (dik == FLOYD_INF)
+		return;
+	for (int j = 0; j < len; j++) {
+		if (dk[j] == FLOYD_INF)
+			continue;
+		long long cand = (long long)dik + dk[j];
+		if (cand < di[j])
+			di[j] = (cand < INT_MIN) ? INT_MIN : (int)cand;
+	}
+}
+
+#ifdef __x86_64__
+// SSE2 is always present on x86-64, so this needs no runtime check
+static void relaxRowSse2(int* di, const int* dk, int dik, int len)
+{
+	if (dik == FLOYD_INF)
+		return;
+	const __m128i inf = _mm_set1_epi32(FLOYD_INF);
+	const __m128i vik = _mm_set1_epi32(dik);
+	int j = 0;
+	for (; j + 4 <= len; j += 4) {
+		__m128i k = _mm_loadu_si128((const __m128i*)(dk + j));
+		__m128i d = _mm_loadu_si128((const __m128i*)(di + j));
+		__m128i isInf = _mm_cmpeq_epi32(k, inf);
+		// The add wraps where both operands share a sign the sum lacks;
+		// there it saturates to INT_MAX or INT_MIN by that sign
+		__m128i sum = _mm_add_epi32(k, vik);
+		__m128i wraps = _mm_srai_epi32(_mm_andnot_si128(_mm_xor_si128(k, vik), _mm_xor_si128(k, sum)), 31);
+		__m128i bound = _mm_xor_si128(_mm_srai_epi32(k, 31), inf);
+		sum = _mm_or_si128(_mm_andnot_si128(wraps, sum), _mm_and_si128(wraps, bound));
+		// Candidate is dik + dk[j], or INF where dk[j] has no path
+		__m128i cand = _mm_or_si128(_mm_andnot_si128(isInf, sum), _mm_and_si128(isInf, inf));
+		// Signed minimum without SSE4.1
+		__m128i less = _mm_cmplt_epi32(cand, d);
+		d = _mm_or_si128(_mm_and_si128(less, cand), _mm_andnot_si128(less, d));
+		_mm_storeu_si128((__m128i*)(di + j), d);
+	}
+	relaxRowScalar(di + j, dk + j, dik, len - j);
+}
+
+__attribute__((target("avx2")))
+static void relaxRowAvx2(int* di, const int* dk, int dik, int len)
+{
+	if (dik == FLOYD_INF)
+		return;
+	const __m256i inf = _mm256_set1_epi32(FLOYD_INF);
+	const __m256i vik = _mm256_set1_epi32(dik);
+	int j = 0;
+	for (; j + 8 <= len; j += 8) {
+		__m256i k = _mm256_loadu_si256((const __m256i*)(dk + j));
+		__m256i d = _mm256_loadu_si256((const __m256i*)(di + j));
+		__m256i isInf = _mm256_cmpeq_epi32(k, inf);
+		// Saturate the add the same way as the SSE2 kernel
+		__m256i sum = _mm256_add_epi32(k, vik);
+		__m256i wraps = _mm256_srai_epi32(_mm256_andnot_si256(_mm256_xor_si256(k, vik), _mm256_xor_si256(k, sum)), 31);
+		__m256i bound = _mm256_xor_si256(_mm256_srai_epi32(k, 31), inf);
+		sum = _mm256_blendv_epi8(sum, bound, wraps);
+		// Candidate is dik + dk[j], or INF where dk[j] has no path
+		__m256i cand = _mm256_blendv_epi8(sum, inf, isInf);
+		_mm256_storeu_si256((__m256i*)(di + j), _mm256_min_epi32(d, cand));
+	}
+	relaxRowScalar(di + j, dk + j, dik, len - j);
+}
+#endif
+
+typedef void (*RelaxRowFn)(int*, const int*, int, int);
+
+// Pick the widest row kernel the CPU supports, once
+static RelaxRowFn relaxRowKernel()
+{
+#ifdef __x86_64__
+	static RelaxRowFn fn = __builtin_cpu_supports("avx2") ? relaxRowAvx2 : relaxRowSse2;
+	return fn;
+#else
+	return relaxRowScalar;
+#endif
+}
+
+int floydBlockSize(int n, int threads)
+{
+	// A phase-3 tile update touches three B x B tiles (ik, kj, ij);
+	// keep them within half of L2 so they stay resident.
+	long l2 = 0;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+	if (l2 <= 0)
+		l2 = 256 * 1024;
+	
+	int block = 16;
+	while (block < 256 && 3L * (block + 16) * (block + 16) * (long)sizeof(int) <= l2 / 2)
+		block += 16;
+	
+	// With several threads, trade tile size for enough tiles to share out
+	while (threads > 1 && block > 32) {
+		long tiles = (n + block - 1) / block;
+		if (tiles * tiles >= 4L * threads)
+			break;
+		block -= 16;
+	}
+	return block;
+}
+
+// Relax tile (ib, jb) through every k of tile kb
+static void floydTile(int* dist, int n, int block, int ib, int jb, int kb, RelaxRowFn relax)
+{
+	int iEnd = min(n, (ib + 1) * block);
+	int jBegin = jb * block, jLen = min(n, (jb + 1) * block) - jBegin;
+	int kEnd = min(n, (kb + 1) * block);
+	
+	for (int k = kb * block; k < kEnd; k++) {
+		const int* dk = dist + (size_t)k * n + jBegin;
+		for (int i = ib * block; i < iEnd; i++) {
+			// Rows with no path to k cannot improve, skip them outside the inner loop
+			int dik = dist[(size_t)i * n + k];
+			if (dik == FLOYD_INF)
+				continue;
+			relax(dist + (size_t)i * n + jBegin, dk, dik, jLen);
+		}
+	}
+}
+
+void floydBlocked(int* dist, int n, int block, ThreadPool* pool)
+{
+	RelaxRowFn relax = relaxRowKernel();
+	int tiles = (n + block - 1) / block;
+	
+	for (int kb = 0; kb < tiles; kb++) {
+		// Phase 1: the diagonal tile depends only on itself
+		floydTile(dist, n, block, kb, kb, kb, relax);
+		
+		// Phase 2: tiles in row kb and column kb depend only on the diagonal tile
+		function<void(int)> phase2 = [&](int idx) {
+			int t = idx / 2;
+			if (t >= kb) t++;	// Skip the diagonal tile
+			if (idx % 2 == 0) {
+				floydTile(dist, n, block, kb, t, kb, relax);
+			} else {
+				floydTile(dist, n, block, t, kb, kb, relax);
+			}
+		};
+		
+		// Phase 3: every remaining tile depends only on its row and column tiles
+		function<void(int)> phase3 = [&](int idx) {
+			int ib = idx / (tiles - 1), jb = idx % (tiles - 1);
+			if (ib >= kb) ib++;
+			if (jb >= kb) jb++;
+			floydTile(dist, n, block, ib, jb, kb, relax);
+		};
+		
+		// Tiles within a phase are independent, so each phase can be split up
+		int count2 = 2 * (tiles - 1), count3 = (tiles - 1) * (tiles - 1);
+		if (pool) {
+			pool->parallelFor(count2, phase2);
+			pool->parallelFor(count3, phase3);
+		} else {
+			for (int idx = 0; idx < count2; idx++) phase2(idx);
+			for (int idx = 0; idx < count3; idx++) phase3(idx);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef _FLOYDKERNEL_H_
+#define _FLOYDKERNEL_H_
+
+#include <vector>
+#include <climits>
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Saturating "no path" value; it never takes part in an addition
+const int FLOYD_INF = INT_MAX;
+
+int floydBlockSize(int n, int threads);
+void floydBlocked(int* dist, int n, int block, ThreadPool* pool);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,302 @@
+#include "FrontierBfs.h"
+#include "Metrics.h"
+#include "ScratchArena.h"
+#include "VisitMarks.h"
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+
+// Beamer's switching thresholds: go bottom-up once the frontier's edges
+// exceed 1/ALPHA of the unvisited vertices' edges, and back top-down once
+// the frontier holds fewer than 1/BETA of the vertices
+static const long long ALPHA = 14;
+static const long long BETA = 24;
+
+// Vertices per parallel task in the bottom-up sweep, a multiple of 64 so
+// tasks never share a bitmap word
+static const int SWEEP_BLOCK = 64 * 64;
+
+static bool testBit(const uint64_t* bits, int v)
+{
+	return (bits[v >> 6] >> (v & 63)) & 1;
+}
+
+static void setBit(uint64_t* bits, int v)
+{
+	bits[v >> 6] |= 1ULL << (v & 63);
+}
+
+// Pick the direction for the next level from the edge counts
+static bool chooseBottomUp(bool bottomUp, long long frontierEdges, long long unvisitedEdges,
+	long long frontierSize, long long size)
+{
+	if (!bottomUp)
+		return frontierEdges > unvisitedEdges / ALPHA;
+	return frontierSize >= size / BETA;
+}
+
+int bfsOrdered(Graph* graph, bool direct, int source, ThreadPool* pool, int* order)
+{
+	ScratchScope scratch;
+	int size = graph->getSize();
+	int blocks = (size + SWEEP_BLOCK - 1) / SWEEP_BLOCK;
+	
+	// Scratch-backed spans cannot be shared between threads
+	if (!graph->hasStableSpans())
+		pool = nullptr;
+	
+	// rank[v] is v's position in the visit order, valid where v is marked.
+	// Sweep tasks reach the marks through a reference; named directly, the
+	// thread_local would be the running worker's copy.
+	static thread_local VisitMarks marks;
+	VisitMarks& visited = marks;
+	visited.reset(size);
+	int* rank = scratch.take<int>(size);
+	
+	// The direction test wants the edges still unvisited, and counting all
+	// of them is a pass over V. A search that stays small never needs the
+	// test: it goes top-down until its own work reaches V / ALPHA and only
+	// then counts, so a start in a small component costs what it explores.
+	long long totalEdges = -1;	// Entries in the view, -1 until counted
+	long long reachedEdges = graph->getNeighbors(source, direct).count;	// Entries of visited vertices
+	
+	int count = 0;
+	order[count++] = source;
+	rank[source] = 0;
+	visited.mark(source);
+	
+	// Bottom-up scratch, taken on the first bottom-up level: candidates per
+	// block, at most one per vertex of the block, then a counting sort by
+	// parent
+	pair<int, int>* found = nullptr;
+	int* foundCount = nullptr;
+	int* bucketStart = nullptr;
+	
+	bool bottomUp = false;
+	long long scanned = 0;	// Top-down edges; bottom-up sweeps count their own
+	int levelStart = 0;
+	while (levelStart < count) {
+		int levelEnd = count;
+		
+		long long frontierEdges = 0;
+		for (int r = levelStart; r < levelEnd; r++) {
+			frontierEdges += graph->getNeighbors(order[r], direct).count;
+		}
+		if (totalEdges < 0 && (count + scanned + frontierEdges) * ALPHA >= size) {
+			totalEdges = 0;
+			for (int v = 0; v < size; v++) {
+				totalEdges += graph->getNeighbors(v, direct).count;
+			}
+		}
+		if (totalEdges >= 0) {
+			bottomUp = chooseBottomUp(bottomUp, frontierEdges, totalEdges - reachedEdges,
+				levelEnd - levelStart, size);
+		}
+		if (bottomUp && !found) {
+			found = scratch.take<pair<int, int>>((size_t)blocks * SWEEP_BLOCK);
+			foundCount = scratch.take<int>(blocks);
+			bucketStart = scratch.take<int>(size + 1);
+		}
+		
+		if (!bottomUp) {
+			// Top-down: the queue BFS itself, one level at a time
+			scanned += frontierEdges;
+			for (int r = levelStart; r < levelEnd; r++) {
+				EdgeSpan edges = graph->getNeighbors(order[r], direct);
+				for (int k = 0; k < edges.count; k++) {
+					int next = edges.to[k];
+					if (visited.visit(next)) {
+						rank[next] = count;
+						order[count++] = next;
+						reachedEdges += graph->getNeighbors(next, direct).count;
+					}
+				}
+			}
+		} else {
+			// Bottom-up: every unvisited vertex looks for its parent among
+			// its incoming edges. The queue BFS would have reached it from
+			// the frontier vertex that comes first, so all of them are read.
+			function<void(int)> sweep = [&](int b) {
+				pair<int, int>* mine = found + (size_t)b * SWEEP_BLOCK;
+				foundCount[b] = 0;
+				long long seen = 0;
+				int last = min(size, (b + 1) * SWEEP_BLOCK);
+				for (int v = b * SWEEP_BLOCK; v < last; v++) {
+					if (visited.test(v)) continue;
+					int parent = INT_MAX;
+					EdgeSpan edges = graph->getReverseNeighbors(v, direct);
+					seen += edges.count;
+					for (int k = 0; k < edges.count; k++) {
+						int from = edges.to[k];
+						if (!visited.test(from)) continue;
+						int r = rank[from];
+						if (r >= levelStart && r < levelEnd && r < parent)
+							parent = r;
+					}
+					if (parent != INT_MAX)
+						mine[foundCount[b]++] = make_pair(parent, v);
+				}
+				countWork(0, seen, 0, 0);
+			};
+			if (pool) {
+				pool->parallelFor(blocks, sweep);
+			} else {
+				for (int b = 0; b < blocks; b++) sweep(b);
+			}
+			
+			// Stable counting sort on the parent's rank, straight into the
+			// order past the frontier; blocks are already in vertex order,
+			// so children of one parent stay ascending
+			int width = levelEnd - levelStart;
+			fill(bucketStart, bucketStart + width + 1, 0);
+			int total = 0;
+			for (int b = 0; b < blocks; b++) {
+				const pair<int, int>* mine = found + (size_t)b * SWEEP_BLOCK;
+				for (int i = 0; i < foundCount[b]; i++)
+					bucketStart[mine[i].first - levelStart + 1]++;
+				total += foundCount[b];
+			}
+			for (int p = 0; p < width; p++)
+				bucketStart[p + 1] += bucketStart[p];
+			for (int b = 0; b < blocks; b++) {
+				const pair<int, int>* mine = found + (size_t)b * SWEEP_BLOCK;
+				for (int i = 0; i < foundCount[b]; i++)
+					order[count + bucketStart[mine[i].first - levelStart]++] = mine[i].second;
+			}
+			
+			for (int i = 0; i < total; i++) {
+				int next = order[count];
+				rank[next] = count;
+				visited.mark(next);
+				count++;
+				reachedEdges += graph->getNeighbors(next, direct).count;
+			}
+		}
+		levelStart = levelEnd;
+	}
+	countWork(count, scanned, 0, 0);
+	return count;
+}
+
+void bfsLevels(Graph* graph, bool direct, int source, ThreadPool* pool, int* level)
+{
+	ScratchScope scratch;
+	int size = graph->getSize();
+	int words = (size + 63) / 64;
+	int blocks = (size + SWEEP_BLOCK - 1) / SWEEP_BLOCK;
+	
+	// Scratch-backed spans cannot be shared between threads
+	if (!graph->hasStableSpans())
+		pool = nullptr;
+	int threads = pool ? pool->getThreads() : 1;
+	
+	fill(level, level + size, -1);
+	atomic<uint64_t>* visited = scratch.take<atomic<uint64_t>>(words);
+	for (int w = 0; w < words; w++) visited[w].store(0, memory_order_relaxed);
+	uint64_t* inFrontier = scratch.take<uint64_t>(words);
+	long long unvisitedEdges = 0;
+	for (int v = 0; v < size; v++) {
+		unvisitedEdges += graph->getNeighbors(v, direct).count;
+	}
+	
+	// The frontier never holds a vertex twice. Top-down slices cannot tell
+	// ahead how much they will find, so each task collects into its own
+	// list, and the calling thread keeps the lists' capacity between
+	// searches. The tasks reach the lists through a plain reference: named
+	// directly, a thread_local would be the running worker's copy.
+	int* frontier = scratch.take<int>(size);
+	int frontierSize = 0;
+	frontier[frontierSize++] = source;
+	static thread_local vector<vector<int>> lists;
+	vector<vector<int>>& found = lists;
+	if ((int)found.size() < max(threads, blocks))
+		found.resize(max(threads, blocks));
+	level[source] = 0;
+	visited[source >> 6].fetch_or(1ULL << (source & 63), memory_order_relaxed);
+	unvisitedEdges -= graph->getNeighbors(source, direct).count;
+	
+	bool bottomUp = false;
+	long long reached = 1, scanned = 0;	// Top-down edges; bottom-up sweeps count their own
+	for (int depth = 1; frontierSize > 0; depth++) {
+		long long frontierEdges = 0;
+		for (int i = 0; i < frontierSize; i++) {
+			frontierEdges += graph->getNeighbors(frontier[i], direct).count;
+		}
+		bottomUp = chooseBottomUp(bottomUp, frontierEdges, unvisitedEdges, frontierSize, size);
+		
+		int tasks;
+		if (!bottomUp) {
+			// Top-down: slices of the frontier claim their neighbors with an
+			// atomic test-and-set on the visited bitmap
+			scanned += frontierEdges;
+			tasks = threads;
+			int slice = (frontierSize + tasks - 1) / tasks;
+			function<void(int)> expand = [&](int t) {
+				found[t].clear();
+				int last = min(frontierSize, (t + 1) * slice);
+				for (int i = t * slice; i < last; i++) {
+					EdgeSpan edges = graph->getNeighbors(frontier[i], direct);
+					for (int k = 0; k < edges.count; k++) {
+						int next = edges.to[k];
+						uint64_t bit = 1ULL << (next & 63);
+						if (visited[next >> 6].load(memory_order_relaxed) & bit) continue;
+						if (!(visited[next >> 6].fetch_or(bit, memory_order_relaxed) & bit))
+							found[t].push_back(next);
+					}
+				}
+			};
+			if (pool) {
+				pool->parallelFor(tasks, expand);
+			} else {
+				for (int t = 0; t < tasks; t++) expand(t);
+			}
+		} else {
+			// Bottom-up: any incoming edge from the frontier will do, so each
+			// unvisited vertex stops at the first one. Blocks own whole words.
+			fill(inFrontier, inFrontier + words, 0);
+			for (int i = 0; i < frontierSize; i++) setBit(inFrontier, frontier[i]);
+			tasks = blocks;
+			function<void(int)> sweep = [&](int b) {
+				found[b].clear();
+				long long seen = 0;
+				int last = min(size, (b + 1) * SWEEP_BLOCK);
+				for (int v = b * SWEEP_BLOCK; v < last; v++) {
+					uint64_t bit = 1ULL << (v & 63);
+					if (visited[v >> 6].load(memory_order_relaxed) & bit) continue;
+					EdgeSpan edges = graph->getReverseNeighbors(v, direct);
+					for (int k = 0; k < edges.count; k++) {
+						seen++;
+						if (testBit(inFrontier, edges.to[k])) {
+							found[b].push_back(v);
+							break;
+						}
+					}
+				}
+				countWork(0, seen, 0, 0);
+				for (size_t i = 0; i < found[b].size(); i++) {
+					int v = found[b][i];
+					visited[v >> 6].fetch_or(1ULL << (v & 63), memory_order_relaxed);
+				}
+			};
+			if (pool) {
+				pool->parallelFor(tasks, sweep);
+			} else {
+				for (int b = 0; b < tasks; b++) sweep(b);
+			}
+		}
+		
+		// Gather the next frontier
+		frontierSize = 0;
+		for (int t = 0; t < tasks; t++) {
+			for (size_t i = 0; i < found[t].size(); i++) {
+				int next = found[t][i];
+				level[next] = depth;
+				frontier[frontierSize++] = next;
+				unvisitedEdges -= graph->getNeighbors(next, direct).count;
+			}
+		}
+		reached += frontierSize;
+	}
+	countWork(reached, scanned, 0, 0);
+}
\ No newline at end of file
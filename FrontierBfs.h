@@ -0,0 +1,24 @@
+#ifndef _FRONTIERBFS_H_
+#define _FRONTIERBFS_H_
+
+#include <vector>
+#include "Graph.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Direction-optimizing BFS. Each level is expanded top-down from the
+// frontier while it is small and bottom-up from the unvisited vertices
+// over the reverse view once the frontier's edges outweigh theirs.
+
+// Visit order of the queue BFS (lowest number first among a vertex's
+// neighbors, parents in the order they were reached) into order, which
+// has room for every vertex; returns how many were reached. A search
+// that stays within a small part of the graph never touches the rest.
+int bfsOrdered(Graph* graph, bool direct, int source, ThreadPool* pool, int* order);
+
+// Level of every vertex into level, -1 when unreached; no order within a
+// level
+void bfsLevels(Graph* graph, bool direct, int source, ThreadPool* pool, int* level);
+
+#endif
\ No newline at end of file
@@ -13,4 +13,75 @@ Graph::~Graph()
 
 
 bool Graph::getType(){return m_Type;}	
-int Graph::getSize(){return m_Size;}
\ No newline at end of file
+int Graph::getSize(){return m_Size;}
+
+EdgeSpan Graph::getNeighbors(int vertex, bool direct)
+{
+	// Default neighbor range: copy the adjacency map into scratch arrays.
+	// The span stays valid until the next getNeighbors call on this graph.
+	map<int, int> edges;
+	if (direct) {
+		getAdjacentEdgesDirect(vertex, &edges);
+	} else {
+		getAdjacentEdges(vertex, &edges);
+	}
+	
+	m_SpanTo.clear();
+	m_SpanWeight.clear();
+	for (auto& edge : edges) {
+		m_SpanTo.push_back(edge.first);
+		m_SpanWeight.push_back(edge.second);
+	}
+	
+	EdgeSpan span;
+	span.to = m_SpanTo.data();
+	span.weight = m_SpanWeight.data();
+	span.count = (int)m_SpanTo.size();
+	return span;
+}
+
+EdgeSpan Graph::getReverseNeighbors(int vertex, bool direct)
+{
+	// Default reverse range: every u whose neighbor range contains vertex,
+	// with the weight u sees. Costs a scan over all vertices.
+	m_SpanTo.clear();
+	m_SpanWeight.clear();
+	for (int u = 0; u < m_Size; u++) {
+		map<int, int> edges;
+		if (direct) {
+			getAdjacentEdgesDirect(u, &edges);
+		} else {
+			getAdjacentEdges(u, &edges);
+		}
+		
+		map<int, int>::iterator it = edges.find(vertex);
+		if (it != edges.end()) {
+			m_SpanTo.push_back(u);
+			m_SpanWeight.push_back(it->second);
+		}
+	}
+	
+	EdgeSpan span;
+	span.to = m_SpanTo.data();
+	span.weight = m_SpanWeight.data();
+	span.count = (int)m_SpanTo.size();
+	return span;
+}
+
+bool Graph::findEdge(int from, int to, bool direct, int* weight)
+{
+	// Neighbor ranges are sorted, so binary search the row
+	EdgeSpan edges = getNeighbors(from, direct);
+	const int* pos = lower_bound(edges.to, edges.to + edges.count, to);
+	if (pos == edges.to + edges.count || *pos != to)
+		return false;
+	*weight = edges.weight[pos - edges.to];
+	return true;
+}
+
+bool Graph::hasStableSpans()
+{
+	// Scratch-backed spans are overwritten by the next call, so they can
+	// neither be held across calls nor shared between threads
+	return false;
+}
\ No newline at end of file
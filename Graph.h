@@ -16,10 +16,19 @@
 
 using namespace std;
 
+// Read-only view of one vertex's neighbors laid out in parallel arrays
+struct EdgeSpan{
+	const int* to;		// Neighbor vertices in ascending order
+	const int* weight;	// Edge weights, parallel to 'to'
+	int count;		// Number of neighbors
+};
+
 class Graph{	
 protected:
 	bool m_Type;
 	int m_Size;
+	vector<int> m_SpanTo;		// Scratch arrays behind the default getNeighbors
+	vector<int> m_SpanWeight;
 
 public:
 	Graph(bool type, int size);
@@ -31,7 +40,12 @@ public:
 	virtual void getAdjacentEdges(int vertex, map<int, int>* m) = 0;		
 	virtual void getAdjacentEdgesDirect(int vertex, map<int, int>* m) = 0;	
 	virtual void insertEdge(int from, int to, int weight) = 0;				
-	virtual	bool printGraph(ofstream *fout) = 0;
+	virtual bool deleteEdge(int from, int to) = 0;	// False when there is no such edge
+	virtual EdgeSpan getNeighbors(int vertex, bool direct);
+	virtual EdgeSpan getReverseNeighbors(int vertex, bool direct);
+	virtual bool hasStableSpans();
+	bool findEdge(int from, int to, bool direct, int* weight);	// Weight of from -> to in the view
+	virtual	bool printGraph(ostream *fout) = 0;
 };
 
 #endif
\ No newline at end of file
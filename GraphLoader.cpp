@@ -0,0 +1,223 @@
+#include "GraphLoader.h"
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <climits>
+
+// Cursor over the mapped bytes with a hand-rolled integer scanner
+struct ByteCursor{
+	const char* p;
+	const char* end;
+	bool overflow;	// Set once a number falls outside the int range
+
+	// Skip blanks; newlines too when crossLines is set
+	void skipSpace(bool crossLines) {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f'
+			|| (crossLines && *p == '\n')))
+			p++;
+	}
+
+	// Parse one optionally signed integer, false if none starts here or it
+	// does not fit in an int (which also sets overflow)
+	bool readInt(int* value, bool crossLines) {
+		skipSpace(crossLines);
+		const char* q = p;
+		bool negative = false;
+		if (q < end && (*q == '-' || *q == '+')) {
+			negative = (*q == '-');
+			q++;
+		}
+		if (q == end || *q < '0' || *q > '9')
+			return false;
+		
+		// Stop as soon as the digits pass the limit, before v can overflow
+		long long limit = negative ? -(long long)INT_MIN : INT_MAX;
+		long long v = 0;
+		while (q < end && *q >= '0' && *q <= '9') {
+			v = v * 10 + (*q - '0');
+			if (v > limit) {
+				overflow = true;
+				return false;
+			}
+			q++;
+		}
+		p = q;
+		*value = (int)(negative ? -v : v);
+		return true;
+	}
+
+	// Move past the current line, like getline
+	const char* nextLine() {
+		const char* lineEnd = p;
+		while (lineEnd < end && *lineEnd != '\n')
+			lineEnd++;
+		const char* next = (lineEnd < end) ? lineEnd + 1 : end;
+		return next;
+	}
+};
+
+GraphFile::GraphFile()
+{
+	m_Data = nullptr;
+	m_Length = 0;
+	m_Seconds = 0;
+}
+
+GraphFile::~GraphFile()
+{
+	close();
+}
+
+bool GraphFile::open(const char* filename)
+{
+	close();
+	
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0)
+		return false;
+	
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+	
+	// An empty file has nothing to map but still opened fine
+	m_Length = (size_t)st.st_size;
+	if (m_Length > 0) {
+		void* addr = mmap(nullptr, m_Length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED) {
+			::close(fd);
+			m_Length = 0;
+			return false;
+		}
+		// The file is read front to back exactly once
+		madvise(addr, m_Length, MADV_SEQUENTIAL);
+		m_Data = (const char*)addr;
+	}
+	::close(fd);
+	return true;
+}
+
+void GraphFile::close()
+{
+	// Unmap the file if one is mapped
+	if (m_Data)
+		munmap((void*)m_Data, m_Length);
+	m_Data = nullptr;
+	m_Length = 0;
+}
+
+bool GraphFile::parse(EdgeList* edges)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	
+	ByteCursor cur;
+	cur.p = m_Data;
+	cur.end = m_Data + m_Length;
+	cur.overflow = false;
+	
+	// Read graph type (L for List, M for Matrix) and number of vertices
+	cur.skipSpace(true);
+	if (cur.p == cur.end)
+		return false;
+	char type = *cur.p++;
+	int size;
+	if (!cur.readInt(&size, true) || size < 0)
+		return false;
+	if (type != 'L' && type != 'M')
+		return false;
+	
+	// Counting pass: every integer token left is at most one edge field,
+	// so it bounds the edge count and lets the arrays be sized once
+	size_t tokens = 0;
+	for (const char* q = cur.p; q < cur.end; q++) {
+		bool digit = (*q >= '0' && *q <= '9');
+		if (digit && (q == cur.p || q[-1] < '0' || q[-1] > '9'))
+			tokens++;
+	}
+	size_t reserve = (type == 'L') ? tokens / 2 : tokens;
+	
+	edges->type = type;
+	edges->size = size;
+	edges->from.clear();
+	edges->to.clear();
+	edges->weight.clear();
+	edges->from.reserve(reserve);
+	edges->to.reserve(reserve);
+	edges->weight.reserve(reserve);
+	
+	if (type == 'L') {
+		// Skip remaining characters on first line
+		cur.p = cur.nextLine();
+		
+		for (int from = 0; from < size; from++) {
+			if (cur.p == cur.end) break;
+			
+			// Parse vertex number line (just vertex index)
+			ByteCursor line = cur;
+			cur.p = cur.nextLine();
+			int vertex_num;
+			if (!line.readInt(&vertex_num, false)) {
+				if (line.overflow)
+					return false;
+				continue;
+			}
+			
+			// Read next line for edges
+			if (cur.p == cur.end) break;
+			line = cur;
+			line.end = cur.nextLine();
+			cur.p = line.end;
+			
+			int to, weight;
+			// Read all edges for this vertex
+			while (line.readInt(&to, false) && line.readInt(&weight, false)) {
+				if (to < 0 || to >= size)
+					return false;
+				edges->from.push_back(from);
+				edges->to.push_back(to);
+				edges->weight.push_back(weight);
+			}
+			if (line.overflow)
+				return false;
+		}
+	} else {
+		// Read adjacency matrix format, only non-zero weights are edges
+		for (int i = 0; i < size; i++) {
+			for (int j = 0; j < size; j++) {
+				int weight;
+				if (!cur.readInt(&weight, true)) {
+					if (cur.overflow)
+						return false;
+					break;
+				}
+				if (weight != 0) {
+					edges->from.push_back(i);
+					edges->to.push_back(j);
+					edges->weight.push_back(weight);
+				}
+			}
+		}
+	}
+	
+	m_Seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+const char* GraphFile::getData()
+{
+	return m_Data;
+}
+
+size_t GraphFile::getBytes()
+{
+	return m_Length;
+}
+
+double GraphFile::getSeconds()
+{
+	return m_Seconds;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef _GRAPHLOADER_H_
+#define _GRAPHLOADER_H_
+
+#include <vector>
+
+using namespace std;
+
+// Edges parsed from a graph_L / graph_M file, in file order
+struct EdgeList{
+	char type;		// 'L' or 'M'
+	int size;		// Number of vertices
+	vector<int> from;
+	vector<int> to;
+	vector<int> weight;
+};
+
+// Memory-mapped graph file parsed straight from the mapped bytes
+class GraphFile{
+private:
+	const char* m_Data;	// Start of the mapping
+	size_t m_Length;	// Mapped length in bytes
+	double m_Seconds;	// Time spent in parse()
+
+public:
+	GraphFile();
+	~GraphFile();
+
+	bool open(const char* filename);
+	bool parse(EdgeList* edges);
+	void close();
+
+	const char* getData();
+	size_t getBytes();
+	double getSeconds();
+};
+
+#endif
\ No newline at end of file
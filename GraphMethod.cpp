@@ -2,27 +2,35 @@
 #include <vector>
 #include <fstream>
 #include "GraphMethod.h"
-#include <stack>
 #include <queue>
-#include <map>
-#include <set>
 #include <list>
 #include <utility>
 #include <algorithm>
 #include <climits>
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include "FloydKernel.h"
+#include "SparsePaths.h"
+#include "IndexedHeap.h"
+#include "FrontierBfs.h"
+#include "Metrics.h"
+#include "ScratchArena.h"
+#include "VisitMarks.h"
 
 using namespace std;
 
-// Union-Find data structure for Kruskal's algorithm
+// Union-Find data structure for Kruskal's algorithm; its arrays live in
+// the caller's scratch scope
 class UnionFind {
 private:
-	vector<int> parent;
-	vector<int> rank;
+	int* parent;
+	int* rank;
 	
 public:
-	UnionFind(int n) {
-		parent.resize(n);
-		rank.resize(n, 0);
+	UnionFind(int n, ScratchScope& scratch) {
+		parent = scratch.take<int>(n);
+		rank = scratch.take<int>(n, 0);
 		for (int i = 0; i < n; i++) {
 			parent[i] = i;
 		}
@@ -55,520 +63,1301 @@ public:
 	}
 };
 
-bool BFS(Graph* graph, char option, int vertex)
+// Textbook queue BFS; the visit order is what BFS prints. The queue is
+// the order itself, read from the front as vertices are appended, so it
+// needs no storage of its own, and the visited marks are cleared by
+// bumping an epoch. Returns how many vertices were reached.
+static int queueOrder(Graph* graph, bool direct, int vertex, int* order)
 {
-	ofstream fout("log.txt", ios::app);
-	
-	int size = graph->getSize();
-	vector<bool> visited(size, false);
-	queue<int> q;
-	vector<int> result;
+	static thread_local VisitMarks visited;
+	visited.reset(graph->getSize());
+	int head = 0, tail = 0;
+	long long scanned = 0;
 	
 	// Start BFS from given vertex
-	q.push(vertex);
-	visited[vertex] = true;
+	order[tail++] = vertex;
+	visited.mark(vertex);
 	
-	while (!q.empty()) {
-		int curr = q.front();
-		q.pop();
-		result.push_back(curr);
+	while (head < tail) {
+		int curr = order[head++];
 		
 		// Get adjacent edges based on direction option
-		map<int, int> edges;
-		if (option == 'O') {
-			graph->getAdjacentEdgesDirect(curr, &edges);
-		} else {
-			graph->getAdjacentEdges(curr, &edges);
-		}
+		EdgeSpan edges = graph->getNeighbors(curr, direct);
+		scanned += edges.count;
 		
 		// Visit adjacent vertices in sorted order (lowest number first)
-		for (auto& edge : edges) {
-			int next = edge.first;
-			if (!visited[next]) {
-				visited[next] = true;
-				q.push(next);
+		for (int k = 0; k < edges.count; k++) {
+			int next = edges.to[k];
+			if (visited.visit(next)) {
+				order[tail++] = next;
 			}
 		}
 	}
+	countWork(tail, scanned, 0, 0);
+	return tail;
+}
+
+bool BFS(Graph* graph, char option, int vertex, ostream* fout, char mode, ThreadPool* pool)
+{
+	ScratchScope scratch;
+	int* result = scratch.take<int>(graph->getSize());
+	int count;
+	if (mode == 'Q') {
+		count = queueOrder(graph, option == 'O', vertex, result);
+	} else {
+		// Same order from the direction-optimizing search
+		count = bfsOrdered(graph, option == 'O', vertex, pool, result);
+	}
 	
 	// Print result
-	fout << "========BFS========" << endl;
+	*fout << "========BFS========" << '\n';
 	if (option == 'O') {
-		fout << "Directed Graph BFS" << endl;
+		*fout << "Directed Graph BFS" << '\n';
 	} else {
-		fout << "Undirected Graph BFS" << endl;
+		*fout << "Undirected Graph BFS" << '\n';
 	}
-	fout << "Start: " << vertex << endl;
+	*fout << "Start: " << vertex << '\n';
 	
-	for (size_t i = 0; i < result.size(); i++) {
-		fout << result[i];
-		if (i < result.size() - 1) fout << " -> ";
+	for (int i = 0; i < count; i++) {
+		*fout << result[i];
+		if (i < count - 1) *fout << " -> ";
 	}
-	fout << endl;
-	fout << "====================" << endl << endl;
+	*fout << '\n';
+	*fout << "====================" << '\n' << '\n';
 	
-	fout.close();
 	return true;
 }
 
-bool DFS(Graph* graph, char option, int vertex)
+bool BFSLevel(Graph* graph, char option, int vertex, ostream* fout, ThreadPool* pool)
 {
-	ofstream fout("log.txt", ios::app);
+	ScratchScope scratch;
+	int size = graph->getSize();
+	int* level = scratch.take<int>(size);
+	bfsLevels(graph, option == 'O', vertex, pool, level);
+	
+	// Group vertices by level with a counting sort; each level lists its
+	// vertices ascending
+	int depth = 0;
+	for (int v = 0; v < size; v++) {
+		depth = max(depth, level[v] + 1);
+	}
+	int* start = scratch.take<int>(depth + 1, 0);
+	for (int v = 0; v < size; v++) {
+		if (level[v] >= 0) start[level[v] + 1]++;
+	}
+	for (int d = 0; d < depth; d++) start[d + 1] += start[d];
+	int* byLevel = scratch.take<int>(start[depth]);
+	int* fillAt = scratch.take<int>(depth);
+	copy(start, start + depth, fillAt);
+	for (int v = 0; v < size; v++) {
+		if (level[v] >= 0) byLevel[fillAt[level[v]]++] = v;
+	}
 	
+	// Print result
+	*fout << "========BFSLEVEL========" << '\n';
+	if (option == 'O') {
+		*fout << "Directed Graph BFS Levels" << '\n';
+	} else {
+		*fout << "Undirected Graph BFS Levels" << '\n';
+	}
+	*fout << "Start: " << vertex << '\n';
+	for (int d = 0; d < depth; d++) {
+		*fout << "[" << d << "]";
+		for (int i = start[d]; i < start[d + 1]; i++) {
+			*fout << " " << byLevel[i];
+		}
+		*fout << '\n';
+	}
+	*fout << "====================" << '\n' << '\n';
+	
+	return true;
+}
+
+// Preorder of a depth-first search that takes neighbors lowest number
+// first, written to result; returns its length. The stack holds one frame
+// per vertex on the current path, with the index of the next edge to
+// try, so it never exceeds V frames and comes from scratch; the visited
+// marks are cleared by bumping an epoch.
+static int dfsPreorder(Graph* graph, bool direct, int vertex, int* result)
+{
+	struct Frame{
+		int vertex;
+		int next;	// Index into the vertex's sorted neighbors
+	};
+	ScratchScope scratch;
 	int size = graph->getSize();
-	vector<bool> visited(size, false);
-	stack<int> s;
-	vector<int> result;
+	Frame* stack = scratch.take<Frame>(size);
+	static thread_local VisitMarks visited;
+	visited.reset(size);
+	int depth = 0, count = 0;
+	long long scanned = 0;
 	
 	// Start DFS from given vertex
-	s.push(vertex);
+	visited.mark(vertex);
+	result[count++] = vertex;
+	stack[depth++] = {vertex, 0};
 	
-	while (!s.empty()) {
-		int curr = s.top();
-		s.pop();
+	while (depth > 0) {
+		Frame& top = stack[depth - 1];
+		EdgeSpan edges = graph->getNeighbors(top.vertex, direct);
 		
-		if (visited[curr]) continue;
-		
-		visited[curr] = true;
-		result.push_back(curr);
-		
-		// Get adjacent edges based on direction option
-		map<int, int> edges;
-		if (option == 'O') {
-			graph->getAdjacentEdgesDirect(curr, &edges);
-		} else {
-			graph->getAdjacentEdges(curr, &edges);
+		// Skip neighbors visited since this frame last looked
+		while (top.next < edges.count && visited.test(edges.to[top.next])) {
+			top.next++;
 		}
-		
-		// Push adjacent vertices in reverse order for correct DFS order
-		vector<int> neighbors;
-		for (auto& edge : edges) {
-			neighbors.push_back(edge.first);
+		if (top.next == edges.count) {
+			scanned += edges.count;
+			depth--;	// Every neighbor done, back up
+			continue;
 		}
-		sort(neighbors.rbegin(), neighbors.rend());
 		
-		for (int next : neighbors) {
-			if (!visited[next]) {
-				s.push(next);
-			}
-		}
+		// Descend into the lowest unvisited neighbor
+		int next = edges.to[top.next++];
+		visited.mark(next);
+		result[count++] = next;
+		stack[depth++] = {next, 0};
 	}
+	countWork(count, scanned, 0, 0);
+	return count;
+}
+
+bool DFS(Graph* graph, char option, int vertex, ostream* fout)
+{
+	ScratchScope scratch;
+	int* result = scratch.take<int>(graph->getSize());
+	int count = dfsPreorder(graph, option == 'O', vertex, result);
 	
 	// Print result
-	fout << "========DFS========" << endl;
+	*fout << "========DFS========" << '\n';
 	if (option == 'O') {
-		fout << "Directed Graph DFS" << endl;
+		*fout << "Directed Graph DFS" << '\n';
 	} else {
-		fout << "Undirected Graph DFS" << endl;
+		*fout << "Undirected Graph DFS" << '\n';
 	}
-	fout << "Start: " << vertex << endl;
+	*fout << "Start: " << vertex << '\n';
 	
-	for (size_t i = 0; i < result.size(); i++) {
-		fout << result[i];
-		if (i < result.size() - 1) fout << " -> ";
+	for (int i = 0; i < count; i++) {
+		*fout << result[i];
+		if (i < count - 1) *fout << " -> ";
 	}
-	fout << endl;
-	fout << "====================" << endl << endl;
+	*fout << '\n';
+	*fout << "====================" << '\n' << '\n';
 	
-	fout.close();
 	return true;
 }
 
-bool Kruskal(Graph* graph)
+// One undirected MST candidate, kept in (from, to) order of generation
+struct MstEdge{
+	int weight;
+	int from;
+	int to;
+};
+
+// Every vertex pair joined in either direction, once. The pair takes the
+// edge with the lower 'from' (a -> b over b -> a for a < b), the one
+// Kruskal saw first, and self-loops are left out since they never join
+// two trees. Edges come out in (from, to) order by merging each vertex's
+// outgoing span with its incoming one.
+static void collectMstEdges(Graph* graph, vector<MstEdge>& edges)
 {
-	ofstream fout("log.txt", ios::app);
-	
 	int size = graph->getSize();
-	vector<pair<int, pair<int, int>>> edges;  // {weight, {from, to}}
+	bool stable = graph->hasStableSpans();
+	static thread_local vector<int> outTo, outWeight;
+	edges.clear();
 	
-	// Collect all edges (treating as undirected)
-	set<pair<int, int>> added;
 	for (int i = 0; i < size; i++) {
-		map<int, int> adjEdges;
-		graph->getAdjacentEdgesDirect(i, &adjEdges);
+		EdgeSpan out = graph->getNeighbors(i, true);
 		
-		for (auto& edge : adjEdges) {
-			int to = edge.first;
-			int weight = edge.second;
-			int a = min(i, to);
-			int b = max(i, to);
-			
-			if (added.find({a, b}) == added.end()) {
-				edges.push_back({weight, {i, to}});
-				added.insert({a, b});
+		// Scratch-backed spans are overwritten by the next call, so copy
+		if (!stable) {
+			outTo.assign(out.to, out.to + out.count);
+			outWeight.assign(out.weight, out.weight + out.count);
+			out.to = outTo.data();
+			out.weight = outWeight.data();
+		}
+		EdgeSpan in = graph->getReverseNeighbors(i, true);
+		
+		// i -> to is kept unless to < i and to -> i was already taken
+		int k = 0;
+		for (int o = 0; o < out.count; o++) {
+			int to = out.to[o];
+			if (to == i) continue;
+			if (to < i) {
+				while (k < in.count && in.to[k] < to) k++;
+				if (k < in.count && in.to[k] == to) continue;
 			}
+			edges.push_back({out.weight[o], i, to});
+		}
+	}
+}
+
+// Stable LSD radix sort on the weight, two 16-bit digits. Equal weights
+// keep their (from, to) order, which is how the pair sort broke ties.
+static void radixSortMstEdges(vector<MstEdge>& edges)
+{
+	ScratchScope scratch;
+	size_t total = edges.size();
+	const int DIGITS = 1 << 16;
+	MstEdge* from = edges.data();
+	MstEdge* to = scratch.take<MstEdge>(total);
+	size_t* count = scratch.take<size_t>(DIGITS);
+	for (int shift = 0; shift < 32; shift += 16) {
+		fill(count, count + DIGITS, 0);
+		for (size_t e = 0; e < total; e++) {
+			uint32_t key = (uint32_t)from[e].weight ^ 0x80000000u;	// Signed order
+			count[(key >> shift) & 0xFFFF]++;
+		}
+		
+		// A digit every key shares leaves the order as it is
+		bool trivial = false;
+		for (int d = 0; d < DIGITS; d++) {
+			if (count[d] == total) trivial = true;
+		}
+		if (trivial) continue;
+		
+		size_t sum = 0;
+		for (int d = 0; d < DIGITS; d++) {
+			size_t c = count[d];
+			count[d] = sum;
+			sum += c;
+		}
+		for (size_t e = 0; e < total; e++) {
+			uint32_t key = (uint32_t)from[e].weight ^ 0x80000000u;
+			to[count[(key >> shift) & 0xFFFF]++] = from[e];
+		}
+		swap(from, to);
+	}
+	if (from != edges.data())
+		copy(from, from + total, edges.data());
+}
+
+// Kruskal over the radix-sorted edges, stopping at V - 1 tree edges
+static void kruskalTree(int size, vector<MstEdge>& edges, vector<MstEdge>& tree)
+{
+	radixSortMstEdges(edges);
+	ScratchScope scratch;
+	UnionFind uf(size, scratch);
+	for (size_t e = 0; e < edges.size() && (int)tree.size() < size - 1; e++) {
+		if (uf.unite(edges[e].from, edges[e].to)) {
+			tree.push_back(edges[e]);
 		}
 	}
+}
+
+// Parallel Boruvka. Every round each tree picks its lightest outgoing edge,
+// with ties broken by (from, to) through the generation index, and all
+// picks are joined at once. That strict order has a single minimum
+// spanning forest, the one Kruskal finds, so the output is the same.
+static void boruvkaTree(int size, const vector<MstEdge>& edges, vector<MstEdge>& tree, ThreadPool* pool)
+{
+	ScratchScope scratch;
+	UnionFind uf(size, scratch);
+	int* comp = scratch.take<int>(size);
+	for (int v = 0; v < size; v++) comp[v] = v;
 	
-	// Sort edges by weight
-	sort(edges.begin(), edges.end());
+	// Picks packed as (weight, index) so one atomic min settles each tree
+	atomic<uint64_t>* best = scratch.take<atomic<uint64_t>>(size);
+	const uint64_t NONE = UINT64_MAX;
 	
-	// Apply Kruskal's algorithm using Union-Find
-	UnionFind uf(size);
-	vector<map<int, int>> mst(size);
-	int totalCost = 0;
-	int edgeCount = 0;
+	size_t liveCount = edges.size();
+	uint32_t* live = scratch.take<uint32_t>(liveCount);
+	for (size_t e = 0; e < liveCount; e++) live[e] = (uint32_t)e;
 	
-	for (auto& e : edges) {
-		int weight = e.first;
-		int from = e.second.first;
-		int to = e.second.second;
+	// Each task keeps its survivors in its own stretch of one array, as
+	// long as the largest slice
+	int tasks = pool ? pool->getThreads() * 4 : 1;
+	size_t stretch = (liveCount + tasks - 1) / tasks;
+	uint32_t* kept = scratch.take<uint32_t>(stretch * tasks);
+	size_t* keptCount = scratch.take<size_t>(tasks);
+	while (liveCount > 0) {
+		for (int v = 0; v < size; v++) best[v].store(NONE, memory_order_relaxed);
 		
-		if (uf.unite(from, to)) {
-			mst[from][to] = weight;
-			mst[to][from] = weight;
-			totalCost += weight;
-			edgeCount++;
+		// Each live edge offers itself to both of its trees
+		size_t slice = (liveCount + tasks - 1) / tasks;
+		function<void(int)> offer = [&](int t) {
+			size_t last = min(liveCount, (t + 1) * slice);
+			for (size_t i = t * slice; i < last; i++) {
+				const MstEdge& e = edges[live[i]];
+				uint64_t key = ((uint64_t)((uint32_t)e.weight ^ 0x80000000u) << 32) | live[i];
+				int ends[2] = {comp[e.from], comp[e.to]};
+				for (int side = 0; side < 2; side++) {
+					atomic<uint64_t>& slot = best[ends[side]];
+					uint64_t seen = slot.load(memory_order_relaxed);
+					while (key < seen && !slot.compare_exchange_weak(seen, key, memory_order_relaxed)) {
+					}
+				}
+			}
+		};
+		if (pool) {
+			pool->parallelFor(tasks, offer);
+		} else {
+			offer(0);
+		}
+		
+		// Join every tree to its pick; a pick two trees share joins once
+		bool joined = false;
+		for (int v = 0; v < size; v++) {
+			uint64_t key = best[v].load(memory_order_relaxed);
+			if (comp[v] != v || key == NONE) continue;
+			const MstEdge& e = edges[(uint32_t)key];
+			if (uf.unite(e.from, e.to)) {
+				tree.push_back(e);
+				joined = true;
+			}
+		}
+		if (!joined) break;
+		for (int v = 0; v < size; v++) comp[v] = uf.find(v);
+		
+		// Keep only the edges that still join two different trees
+		function<void(int)> filter = [&](int t) {
+			keptCount[t] = 0;
+			uint32_t* mine = kept + t * stretch;
+			size_t last = min(liveCount, (t + 1) * slice);
+			for (size_t i = t * slice; i < last; i++) {
+				const MstEdge& e = edges[live[i]];
+				if (comp[e.from] != comp[e.to]) mine[keptCount[t]++] = live[i];
+			}
+		};
+		if (pool) {
+			pool->parallelFor(tasks, filter);
+		} else {
+			filter(0);
+		}
+		liveCount = 0;
+		for (int t = 0; t < tasks; t++) {
+			copy(kept + t * stretch, kept + t * stretch + keptCount[t], live + liveCount);
+			liveCount += keptCount[t];
 		}
 	}
+}
+
+bool Kruskal(Graph* graph, ostream* fout, char mode, ThreadPool* pool)
+{
+	int size = graph->getSize();
+	
+	// Scratch-backed spans cannot be shared between threads
+	if (!graph->hasStableSpans())
+		pool = nullptr;
+	
+	// Deduplicated candidates, then the tree as a flat edge list. Both
+	// lists keep their capacity on this thread for the next MST.
+	static thread_local vector<MstEdge> edges, tree;
+	collectMstEdges(graph, edges);
+	countWork(size, edges.size(), 0, 0);
+	tree.clear();
+	if (mode == 'B') {
+		boruvkaTree(size, edges, tree, pool);
+	} else {
+		kruskalTree(size, edges, tree);
+	}
 	
 	// Check if MST is valid (all vertices connected)
-	if (edgeCount != size - 1) {
-		fout.close();
+	if ((int)tree.size() != size - 1) {
 		return false;
 	}
 	
-	// Print MST in adjacency list format
-	fout << "========KRUSKAL========" << endl;
+	// Both ends of each tree edge, grouped by vertex with a counting sort
+	ScratchScope scratch;
+	int* start = scratch.take<int>(size + 1, 0);
+	for (size_t e = 0; e < tree.size(); e++) {
+		start[tree[e].from + 1]++;
+		start[tree[e].to + 1]++;
+	}
+	for (int v = 0; v < size; v++) start[v + 1] += start[v];
+	pair<int, int>* adj = scratch.take<pair<int, int>>(start[size]);	// {neighbor, weight}
+	int* fillAt = scratch.take<int>(size);
+	copy(start, start + size, fillAt);
+	int totalCost = 0;
+	for (size_t e = 0; e < tree.size(); e++) {
+		adj[fillAt[tree[e].from]++] = {tree[e].to, tree[e].weight};
+		adj[fillAt[tree[e].to]++] = {tree[e].from, tree[e].weight};
+		totalCost += tree[e].weight;
+	}
+	
+	// Print MST in adjacency list format, neighbors ascending
+	*fout << "========KRUSKAL========" << '\n';
 	for (int i = 0; i < size; i++) {
-		fout << "[" << i << "]";
-		for (auto& edge : mst[i]) {
-			fout << " " << edge.first << "(" << edge.second << ")";
+		sort(adj + start[i], adj + start[i + 1]);
+		*fout << "[" << i << "]";
+		for (int k = start[i]; k < start[i + 1]; k++) {
+			*fout << " " << adj[k].first << "(" << adj[k].second << ")";
 		}
-		fout << endl;
+		*fout << '\n';
 	}
-	fout << "Cost: " << totalCost << endl;
-	fout << "====================" << endl << endl;
+	*fout << "Cost: " << totalCost << '\n';
+	*fout << "====================" << '\n' << '\n';
 	
-	fout.close();
 	return true;
 }
 
-bool Dijkstra(Graph* graph, char option, int vertex)
+// Dijkstra with a binary heap of pairs and lazy deletion: every relaxation
+// pushes a new entry and stale ones are skipped when popped. The heap is a
+// per-thread vector run through push_heap/pop_heap, as priority_queue
+// would, so it keeps its capacity between runs.
+static void dijkstraLazy(Graph* graph, bool direct, int vertex, vector<int>& dist, vector<int>& prev,
+	HeapStats* stats)
 {
-	ofstream fout("log.txt", ios::app);
+	static thread_local vector<pair<int, int>> pq;
+	greater<pair<int, int>> later;
+	pq.clear();
 	
-	int size = graph->getSize();
+	dist[vertex] = 0;
+	pq.push_back({0, vertex});
+	stats->pushes = 1;
+	stats->pops = 0;
+	stats->decreaseKeys = 0;
+	stats->peak = 1;
+	long long settled = 0, scanned = 0;
 	
-	// Check for negative weights
-	for (int i = 0; i < size; i++) {
-		map<int, int> edges;
-		graph->getAdjacentEdgesDirect(i, &edges);
-		for (auto& edge : edges) {
-			if (edge.second < 0) {
-				fout.close();
-				return false;
+	while (!pq.empty()) {
+		int d = pq.front().first;
+		int curr = pq.front().second;
+		pop_heap(pq.begin(), pq.end(), later);
+		pq.pop_back();
+		stats->pops++;
+		
+		if (d > dist[curr]) continue;
+		
+		// Get adjacent edges
+		EdgeSpan edges = graph->getNeighbors(curr, direct);
+		settled++;
+		scanned += edges.count;
+		
+		// Relax edges
+		for (int k = 0; k < edges.count; k++) {
+			int next = edges.to[k];
+			int weight = edges.weight[k];
+			
+			if (dist[curr] != INT_MAX && dist[curr] + weight < dist[next]) {
+				dist[next] = dist[curr] + weight;
+				prev[next] = curr;
+				pq.push_back({dist[next], next});
+				push_heap(pq.begin(), pq.end(), later);
+				stats->pushes++;
+				if ((int)pq.size() > stats->peak)
+					stats->peak = (int)pq.size();
 			}
 		}
 	}
-	
-	// Initialize distances and previous vertices
-	vector<int> dist(size, INT_MAX);
-	vector<int> prev(size, -1);
-	priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+	countWork(settled, scanned, stats->pushes, stats->pushes - 1);	// Every push after the source relaxed an edge
+}
+
+// Dijkstra with the indexed 4-ary heap: a relaxation lowers the vertex's
+// key in place, so the heap holds at most V entries and nothing goes stale
+static void dijkstraIndexed(Graph* graph, bool direct, int vertex, vector<int>& dist, vector<int>& prev,
+	HeapStats* stats)
+{
+	// One heap per thread, reused between runs
+	static thread_local IndexedHeap heap;
+	heap.reset(graph->getSize());
 	
 	dist[vertex] = 0;
-	pq.push({0, vertex});
+	heap.push(vertex, 0);
+	long long scanned = 0;
 	
-	// Dijkstra's algorithm
-	while (!pq.empty()) {
-		int d = pq.top().first;
-		int curr = pq.top().second;
-		pq.pop();
-		
-		if (d > dist[curr]) continue;
+	while (!heap.empty()) {
+		long long d;
+		int curr = heap.pop(&d);
 		
 		// Get adjacent edges
-		map<int, int> edges;
-		if (option == 'O') {
-			graph->getAdjacentEdgesDirect(curr, &edges);
-		} else {
-			graph->getAdjacentEdges(curr, &edges);
-		}
+		EdgeSpan edges = graph->getNeighbors(curr, direct);
+		scanned += edges.count;
 		
 		// Relax edges
-		for (auto& edge : edges) {
-			int next = edge.first;
-			int weight = edge.second;
+		for (int k = 0; k < edges.count; k++) {
+			int next = edges.to[k];
+			int weight = edges.weight[k];
 			
 			if (dist[curr] != INT_MAX && dist[curr] + weight < dist[next]) {
 				dist[next] = dist[curr] + weight;
 				prev[next] = curr;
-				pq.push({dist[next], next});
+				heap.push(next, dist[next]);
 			}
 		}
 	}
+	*stats = heap.getStats();
+	countWork(stats->pops, scanned, stats->pushes, stats->pushes + stats->decreaseKeys - 1);
+}
+
+// Largest edge weight for which Dial's buckets beat a heap
+const int DIAL_MAX_WEIGHT = 1024;
+
+// Dijkstra with Dial's bucket queue for weights in [1, maxWeight]. Pending
+// distances lie in [d, d + maxWeight], so maxWeight + 1 buckets used as a
+// ring hold them all. A bucket is sorted by vertex before it is settled,
+// which keeps the (distance, vertex) order of the heaps.
+static void dijkstraDial(Graph* graph, bool direct, int vertex, int maxWeight, vector<int>& dist,
+	vector<int>& prev, HeapStats* stats)
+{
+	// Buckets per thread, reused between runs
+	static thread_local vector<vector<int>> buckets;
+	int ring = maxWeight + 1;
+	if ((int)buckets.size() < ring)
+		buckets.resize(ring);
+	for (int b = 0; b < ring; b++)
+		buckets[b].clear();
+	
+	dist[vertex] = 0;
+	buckets[0].push_back(vertex);
+	long long pending = 1;	// Entries in all buckets, stale ones included
+	stats->pushes = 1;
+	stats->pops = 0;
+	stats->decreaseKeys = 0;
+	stats->peak = 1;
+	long long settled = 0, scanned = 0;
+	
+	for (int d = 0; pending > 0; d++) {
+		// Weights are at least 1, so nothing is added to this bucket while
+		// it is being settled
+		vector<int>& bucket = buckets[d % ring];
+		if (bucket.empty()) continue;
+		sort(bucket.begin(), bucket.end());
+		pending -= bucket.size();
+		stats->pops += bucket.size();
+		
+		for (size_t b = 0; b < bucket.size(); b++) {
+			int curr = bucket[b];
+			
+			// Stale entry: the vertex was settled at a smaller distance
+			if (dist[curr] != d) continue;
+			
+			// Relax edges
+			EdgeSpan edges = graph->getNeighbors(curr, direct);
+			settled++;
+			scanned += edges.count;
+			for (int k = 0; k < edges.count; k++) {
+				int next = edges.to[k];
+				int weight = edges.weight[k];
+				
+				if (d + weight < dist[next]) {
+					dist[next] = d + weight;
+					prev[next] = curr;
+					buckets[dist[next] % ring].push_back(next);
+					pending++;
+					stats->pushes++;
+					if (pending > stats->peak)
+						stats->peak = (int)pending;
+				}
+			}
+		}
+		bucket.clear();
+	}
+	countWork(settled, scanned, stats->pushes, stats->pushes - 1);
+}
+
+// Scan the weights once: false on a negative weight, otherwise resolve
+// the heap choice ('A'uto or an unusable 'D'ial) to the queue to run
+static bool dijkstraQueue(Graph* graph, char heap, char* chosen, int* maxWeightOut)
+{
+	int size = graph->getSize();
+	
+	// Check for negative weights, noting the weight range on the way
+	int minWeight = INT_MAX;
+	int maxWeight = 0;
+	for (int i = 0; i < size; i++) {
+		EdgeSpan edges = graph->getNeighbors(i, true);
+		for (int k = 0; k < edges.count; k++) {
+			if (edges.weight[k] < 0) {
+				return false;
+			}
+			minWeight = min(minWeight, edges.weight[k]);
+			maxWeight = max(maxWeight, edges.weight[k]);
+		}
+	}
+	
+	// Dial's buckets need weights of at least 1 and a small maximum;
+	// otherwise fall back to the indexed heap
+	bool dial = (minWeight >= 1 && minWeight != INT_MAX && maxWeight <= DIAL_MAX_WEIGHT);
+	if (heap == 'A') {
+		heap = dial ? 'D' : 'I';
+	} else if (heap == 'D' && !dial) {
+		heap = 'I';
+	}
+	*chosen = heap;
+	*maxWeightOut = maxWeight;
+	return true;
+}
+
+// One single-source run with a resolved queue; dist and prev are resized
+// in place, so buffers passed in again are reused
+static void dijkstraRun(Graph* graph, bool direct, int vertex, char heap, int maxWeight,
+	vector<int>& dist, vector<int>& prev, HeapStats* stats)
+{
+	// Initialize distances and previous vertices
+	int size = graph->getSize();
+	dist.assign(size, INT_MAX);
+	prev.assign(size, -1);
+	
+	// Every queue settles vertices in (distance, vertex) order, so the
+	// paths they leave in prev are the same
+	if (heap == 'B') {
+		dijkstraLazy(graph, direct, vertex, dist, prev, stats);
+	} else if (heap == 'D') {
+		dijkstraDial(graph, direct, vertex, maxWeight, dist, prev, stats);
+	} else {
+		dijkstraIndexed(graph, direct, vertex, dist, prev, stats);
+	}
+}
+
+static const char* dijkstraQueueName(char heap)
+{
+	if (heap == 'B') return "binary heap";
+	if (heap == 'D') return "dial buckets";
+	return "indexed 4-ary heap";
+}
+
+bool DijkstraTree(Graph* graph, char option, int vertex, vector<int>* dist, vector<int>* prev, char heap)
+{
+	int maxWeight;
+	if (!dijkstraQueue(graph, heap, &heap, &maxWeight)) {
+		return false;
+	}
+	
+	HeapStats stats;
+	dijkstraRun(graph, option == 'O', vertex, heap, maxWeight, *dist, *prev, &stats);
+	if (tracing()) {
+		cerr << "DIJKSTRA " << vertex << ": " << dijkstraQueueName(heap) << ", "
+			<< stats.pushes << " pushes, " << stats.pops << " pops, " << stats.decreaseKeys
+			<< " decrease-keys, peak " << stats.peak << " entries" << '\n';
+	}
+	return true;
+}
+
+void printDijkstra(char option, int vertex, const vector<int>& dist, const vector<int>& prev, ostream* fout)
+{
+	int size = (int)dist.size();
 	
 	// Print results
-	fout << "========DIJKSTRA========" << endl;
+	*fout << "========DIJKSTRA========" << '\n';
 	if (option == 'O') {
-		fout << "Directed Graph Dijkstra" << endl;
+		*fout << "Directed Graph Dijkstra" << '\n';
 	} else {
-		fout << "Undirected Graph Dijkstra" << endl;
+		*fout << "Undirected Graph Dijkstra" << '\n';
 	}
-	fout << "Start: " << vertex << endl;
+	*fout << "Start: " << vertex << '\n';
 	
+	// Paths are read back to front into one scratch array
+	ScratchScope scratch;
+	int* path = scratch.take<int>(size);
 	for (int i = 0; i < size; i++) {
-		fout << "[" << i << "] ";
+		*fout << "[" << i << "] ";
 		
 		if (dist[i] == INT_MAX) {
-			fout << "x" << endl;
+			*fout << "x" << '\n';
 		} else {
 			// Reconstruct path
-			vector<int> path;
-			int curr = i;
-			while (curr != -1) {
-				path.push_back(curr);
-				curr = prev[curr];
+			int length = 0;
+			for (int curr = i; curr != -1; curr = prev[curr]) {
+				path[length++] = curr;
 			}
-			reverse(path.begin(), path.end());
 			
-			for (size_t j = 0; j < path.size(); j++) {
-				fout << path[j];
-				if (j < path.size() - 1) fout << " -> ";
+			for (int j = length - 1; j >= 0; j--) {
+				*fout << path[j];
+				if (j > 0) *fout << " -> ";
 			}
-			fout << " (" << dist[i] << ")" << endl;
+			*fout << " (" << dist[i] << ")" << '\n';
 		}
 	}
-	fout << "====================" << endl << endl;
+	*fout << "====================" << '\n' << '\n';
 	
-	fout.close();
+}
+
+bool Dijkstra(Graph* graph, char option, int vertex, ostream* fout, char heap)
+{
+	// Reused by every call on this thread; the tree is rebuilt in full
+	static thread_local vector<int> dist, prev;
+	if (!DijkstraTree(graph, option, vertex, &dist, &prev, heap)) {
+		return false;
+	}
+	printDijkstra(option, vertex, dist, prev, fout);
 	return true;
 }
 
-bool Bellmanford(Graph* graph, char option, int s_vertex, int e_vertex) 
+bool DijkstraBatch(Graph* graph, char option, const vector<int>& sources, ostream* fout, char heap,
+	ThreadPool* pool)
 {
-	ofstream fout("log.txt", ios::app);
+	// The weight scan and the queue choice are shared by every source
+	int maxWeight;
+	if (!dijkstraQueue(graph, heap, &heap, &maxWeight)) {
+		return false;
+	}
 	
-	int size = graph->getSize();
-	vector<int> dist(size, INT_MAX);
-	vector<int> prev(size, -1);
+	// Scratch-backed spans cannot be shared between threads
+	if (!graph->hasStableSpans())
+		pool = nullptr;
 	
-	dist[s_vertex] = 0;
+	// Sources run in chunks spread over the pool. Each block is rendered
+	// into its slot and the slots are written in source order, so the log
+	// reads as if Dijkstra had been called once per source.
+	int threads = pool ? pool->getThreads() : 1;
+	int chunk = threads * 4;
+	int total = (int)sources.size();
+	vector<string> blocks(min(chunk, total));
+	vector<HeapStats> stats(blocks.size());
+	long long pops = 0;
+	int peak = 0;
 	
-	// Collect all edges
-	vector<tuple<int, int, int>> edges;  // {from, to, weight}
-	for (int i = 0; i < size; i++) {
-		map<int, int> adjEdges;
-		if (option == 'O') {
-			graph->getAdjacentEdgesDirect(i, &adjEdges);
+	for (int first = 0; first < total; first += chunk) {
+		int count = min(chunk, total - first);
+		function<void(int)> runSource = [&](int r) {
+			// Buffers per worker, reused for every source it runs
+			static thread_local vector<int> dist, prev;
+			static thread_local ostringstream out;
+			int vertex = sources[first + r];
+			dijkstraRun(graph, option == 'O', vertex, heap, maxWeight, dist, prev, &stats[r]);
+			out.str("");
+			printDijkstra(option, vertex, dist, prev, &out);
+			blocks[r] = out.str();
+		};
+		if (pool) {
+			pool->parallelFor(count, runSource);
 		} else {
-			graph->getAdjacentEdges(i, &adjEdges);
+			for (int r = 0; r < count; r++) runSource(r);
 		}
 		
-		for (auto& edge : adjEdges) {
-			edges.push_back({i, edge.first, edge.second});
+		for (int r = 0; r < count; r++) {
+			*fout << blocks[r];
+			pops += stats[r].pops;
+			peak = max(peak, stats[r].peak);
 		}
 	}
+	if (tracing()) {
+		cerr << "DIJKSTRA_BATCH: " << total << " sources, " << dijkstraQueueName(heap) << ", "
+			<< pops << " pops, peak " << peak << " entries" << '\n';
+	}
 	
-	// Relax edges |V| - 1 times
-	for (int i = 0; i < size - 1; i++) {
-		for (auto& e : edges) {
-			int from = get<0>(e);
-			int to = get<1>(e);
-			int weight = get<2>(e);
-			
-			if (dist[from] != INT_MAX && dist[from] + weight < dist[to]) {
-				dist[to] = dist[from] + weight;
-				prev[to] = from;
+	return true;
+}
+
+// Pass-based Bellman-Ford over the edges in vertex order, updating in place.
+// A pass that changes nothing means every later pass would change nothing
+// too, so it stops there; false if a reachable negative cycle exists.
+static bool bellmanPasses(Graph* graph, bool direct, vector<int>& dist, vector<int>& prev)
+{
+	int size = graph->getSize();
+	
+	// Relax edges up to |V| - 1 times
+	bool settled = false;
+	long long scannedVertices = 0, scanned = 0, relaxed = 0;
+	for (int i = 0; i < size - 1 && !settled; i++) {
+		settled = true;
+		for (int from = 0; from < size; from++) {
+			if (dist[from] == INT_MAX) continue;
+			EdgeSpan edges = graph->getNeighbors(from, direct);
+			scannedVertices++;
+			scanned += edges.count;
+			for (int k = 0; k < edges.count; k++) {
+				int to = edges.to[k];
+				if (dist[from] + edges.weight[k] < dist[to]) {
+					dist[to] = dist[from] + edges.weight[k];
+					prev[to] = from;
+					settled = false;
+					relaxed++;
+				}
 			}
 		}
 	}
+	countWork(scannedVertices, scanned, 0, relaxed);
+	if (settled) {
+		return true;
+	}
 	
 	// Check for negative cycles
-	for (auto& e : edges) {
-		int from = get<0>(e);
-		int to = get<1>(e);
-		int weight = get<2>(e);
+	for (int from = 0; from < size; from++) {
+		if (dist[from] == INT_MAX) continue;
+		EdgeSpan edges = graph->getNeighbors(from, direct);
+		for (int k = 0; k < edges.count; k++) {
+			if (dist[from] + edges.weight[k] < dist[edges.to[k]]) {
+				return false;  // Negative cycle detected
+			}
+		}
+	}
+	return true;
+}
+
+// SPFA: only vertices whose distance dropped are rescanned, from a FIFO
+// worklist. A shortest path has at most |V| - 1 edges, so a vertex reached
+// over |V| edges means a negative cycle. Nothing here is cleared per run:
+// a vertex's path length is written before it is first queued, and the
+// queued flags are epoch marks.
+static bool bellmanQueue(Graph* graph, bool direct, int s_vertex, vector<int>& dist, vector<int>& prev)
+{
+	ScratchScope scratch;
+	int size = graph->getSize();
+	int* edgesOnPath = scratch.take<int>(size);
+	int* worklist = scratch.take<int>(size);	// Ring buffer; each vertex is queued at most once
+	static thread_local VisitMarks queued;
+	queued.reset(size);
+	int head = 0, count = 0;
+	
+	worklist[0] = s_vertex;
+	edgesOnPath[s_vertex] = 0;
+	queued.mark(s_vertex);
+	count = 1;
+	long long scannedVertices = 0, scanned = 0, pushes = 1, relaxed = 0;
+	
+	bool ok = true;
+	while (count > 0 && ok) {
+		int from = worklist[head];
+		head = (head + 1) % size;
+		count--;
+		queued.unmark(from);
 		
-		if (dist[from] != INT_MAX && dist[from] + weight < dist[to]) {
-			fout.close();
-			return false;  // Negative cycle detected
+		EdgeSpan edges = graph->getNeighbors(from, direct);
+		scannedVertices++;
+		scanned += edges.count;
+		for (int k = 0; k < edges.count; k++) {
+			int to = edges.to[k];
+			if (dist[from] + edges.weight[k] < dist[to]) {
+				dist[to] = dist[from] + edges.weight[k];
+				prev[to] = from;
+				relaxed++;
+				edgesOnPath[to] = edgesOnPath[from] + 1;
+				if (edgesOnPath[to] >= size) {
+					ok = false;  // Negative cycle detected
+					break;
+				}
+				if (queued.visit(to)) {
+					worklist[(head + count) % size] = to;
+					count++;
+					pushes++;
+				}
+			}
 		}
 	}
+	countWork(scannedVertices, scanned, pushes, relaxed);
+	return ok;
+}
+
+// Jacobi-style rounds: every vertex takes the best offer over its incoming
+// edges from the previous round's distances, so vertices are independent
+// and are split across the pool. Round k finds every path of up to k edges;
+// a change in round |V| means a negative cycle.
+static bool bellmanRounds(Graph* graph, bool direct, vector<int>& dist, vector<int>& prev, ThreadPool* pool)
+{
+	ScratchScope scratch;
+	int size = graph->getSize();
+	int* nextDist = scratch.take<int>(size);
+	int* nextPrev = scratch.take<int>(size);
+	copy(dist.begin(), dist.end(), nextDist);
+	copy(prev.begin(), prev.end(), nextPrev);
+	
+	// Vertices are handed out in blocks to keep the per-index cost down
+	const int BLOCK = 256;
+	int blocks = (size + BLOCK - 1) / BLOCK;
+	char* changed = scratch.take<char>(blocks);
+	function<void(int)> relaxBlock = [&](int b) {
+		int last = min(size, (b + 1) * BLOCK);
+		long long scanned = 0, relaxed = 0;
+		changed[b] = 0;
+		for (int to = b * BLOCK; to < last; to++) {
+			EdgeSpan edges = graph->getReverseNeighbors(to, direct);
+			scanned += edges.count;
+			for (int k = 0; k < edges.count; k++) {
+				int from = edges.to[k];
+				if (dist[from] != INT_MAX && dist[from] + edges.weight[k] < nextDist[to]) {
+					nextDist[to] = dist[from] + edges.weight[k];
+					nextPrev[to] = from;
+					changed[b] = 1;
+					relaxed++;
+				}
+			}
+		}
+		countWork(last - b * BLOCK, scanned, 0, relaxed);
+	};
+	
+	for (int round = 0; round < size; round++) {
+		if (pool) {
+			pool->parallelFor(blocks, relaxBlock);
+		} else {
+			for (int b = 0; b < blocks; b++) relaxBlock(b);
+		}
+		if (find(changed, changed + blocks, 1) == changed + blocks) {
+			return true;
+		}
+		copy(nextDist, nextDist + size, dist.begin());
+		copy(nextPrev, nextPrev + size, prev.begin());
+	}
+	return false;  // Negative cycle detected
+}
+
+bool BellmanfordTree(Graph* graph, char option, int s_vertex, vector<int>* distOut, vector<int>* prevOut,
+	char mode, ThreadPool* pool)
+{
+	int size = graph->getSize();
+	vector<int>& dist = *distOut;
+	vector<int>& prev = *prevOut;
+	dist.assign(size, INT_MAX);
+	prev.assign(size, -1);
+	
+	dist[s_vertex] = 0;
 	
+	// Scratch-backed spans cannot be shared between threads
+	if (!graph->hasStableSpans())
+		pool = nullptr;
+	
+	// The worklist and round modes reach the same distances; on ties
+	// between equally short paths they may keep a different one
+	bool ok;
+	if (mode == 'S') {
+		ok = bellmanQueue(graph, option == 'O', s_vertex, dist, prev);
+	} else if (mode == 'P') {
+		ok = bellmanRounds(graph, option == 'O', dist, prev, pool);
+	} else {
+		ok = bellmanPasses(graph, option == 'O', dist, prev);
+	}
+	return ok;
+}
+
+void printBellmanford(char option, int e_vertex, const vector<int>& dist, const vector<int>& prev, ostream* fout)
+{
 	// Print result
-	fout << "========BELLMANFORD========" << endl;
+	*fout << "========BELLMANFORD========" << '\n';
 	if (option == 'O') {
-		fout << "Directed Graph Bellman-Ford" << endl;
+		*fout << "Directed Graph Bellman-Ford" << '\n';
 	} else {
-		fout << "Undirected Graph Bellman-Ford" << endl;
+		*fout << "Undirected Graph Bellman-Ford" << '\n';
 	}
 	
 	if (dist[e_vertex] == INT_MAX) {
-		fout << "x" << endl;
+		*fout << "x" << '\n';
 	} else {
-		// Reconstruct path
-		vector<int> path;
-		int curr = e_vertex;
-		while (curr != -1) {
-			path.push_back(curr);
-			curr = prev[curr];
-		}
-		reverse(path.begin(), path.end());
+		// Reconstruct path, back to front
+		ScratchScope scratch;
+		int* path = scratch.take<int>(dist.size());
+		int length = 0;
+		for (int curr = e_vertex; curr != -1; curr = prev[curr]) {
+			path[length++] = curr;
+		}
 		
-		for (size_t i = 0; i < path.size(); i++) {
-			fout << path[i];
-			if (i < path.size() - 1) fout << " -> ";
+		for (int i = length - 1; i >= 0; i--) {
+			*fout << path[i];
+			if (i > 0) *fout << " -> ";
 		}
-		fout << endl;
-		fout << "Cost: " << dist[e_vertex] << endl;
+		*fout << '\n';
+		*fout << "Cost: " << dist[e_vertex] << '\n';
 	}
-	fout << "====================" << endl << endl;
+	*fout << "====================" << '\n' << '\n';
 	
-	fout.close();
+}
+
+bool Bellmanford(Graph* graph, char option, int s_vertex, int e_vertex, ostream* fout, char mode,
+	ThreadPool* pool)
+{
+	static thread_local vector<int> dist, prev;
+	if (!BellmanfordTree(graph, option, s_vertex, &dist, &prev, mode, pool)) {
+		return false;
+	}
+	printBellmanford(option, e_vertex, dist, prev, fout);
 	return true;
 }
 
-bool FLOYD(Graph* graph, char option)
+bool Query(Graph* graph, char option, int s_vertex, int e_vertex, const QueryIndex* index, ostream* fout)
 {
-	ofstream fout("log.txt", ios::app);
+	// Bidirectional search needs non-negative weights
+	if (index->negative) {
+		return false;
+	}
+	
+	vector<int> path;
+	QueryStats stats;
+	long long cost = pointToPoint(graph, option == 'O', s_vertex, e_vertex, index, &path, &stats);
+	countWork(stats.settled, stats.relaxed, stats.pushes, stats.lowered);
+	if (tracing()) {
+		cerr << "QUERY " << s_vertex << " " << e_vertex << ": " << stats.settled << " settled, "
+			<< stats.relaxed << " edges scanned, " << index->landmarks << " landmarks" << '\n';
+	}
+	
+	// Print result
+	*fout << "========QUERY========" << '\n';
+	if (option == 'O') {
+		*fout << "Directed Graph Query" << '\n';
+	} else {
+		*fout << "Undirected Graph Query" << '\n';
+	}
 	
+	if (cost == SSSP_INF) {
+		*fout << "x" << '\n';
+	} else {
+		for (size_t i = 0; i < path.size(); i++) {
+			*fout << path[i];
+			if (i < path.size() - 1) *fout << " -> ";
+		}
+		*fout << '\n';
+		*fout << "Cost: " << cost << '\n';
+	}
+	*fout << "====================" << '\n' << '\n';
+	
+	return true;
+}
+
+// Fill a contiguous size x size matrix with edge weights and run the
+// blocked Floyd-Warshall kernel over it; false if a negative cycle exists
+static bool allPairsDistances(Graph* graph, bool direct, vector<int>& dist, ThreadPool* pool)
+{
 	int size = graph->getSize();
 	
 	// Initialize distance matrix
-	vector<vector<int>> dist(size, vector<int>(size, INT_MAX));
+	dist.assign((size_t)size * size, FLOYD_INF);
 	
 	// Set diagonal to 0
 	for (int i = 0; i < size; i++) {
-		dist[i][i] = 0;
+		dist[(size_t)i * size + i] = 0;
 	}
 	
 	// Fill in edge weights
+	long long edgeCount = 0;
 	for (int i = 0; i < size; i++) {
-		map<int, int> edges;
-		if (option == 'O') {
-			graph->getAdjacentEdgesDirect(i, &edges);
-		} else {
-			graph->getAdjacentEdges(i, &edges);
-		}
+		EdgeSpan edges = graph->getNeighbors(i, direct);
+		edgeCount += edges.count;
 		
-		for (auto& edge : edges) {
-			dist[i][edge.first] = edge.second;
+		for (int k = 0; k < edges.count; k++) {
+			dist[(size_t)i * size + edges.to[k]] = edges.weight[k];
 		}
 	}
 	
-	// Floyd-Warshall algorithm
-	for (int k = 0; k < size; k++) {
-		for (int i = 0; i < size; i++) {
-			for (int j = 0; j < size; j++) {
-				if (dist[i][k] != INT_MAX && dist[k][j] != INT_MAX) {
-					if (dist[i][k] + dist[k][j] < dist[i][j]) {
-						dist[i][j] = dist[i][k] + dist[k][j];
-					}
-				}
-			}
-		}
-	}
+	// Floyd-Warshall algorithm, tiled to stay in cache and split across the pool.
+	// Every (i, k, j) is one relaxation.
+	countWork(size, edgeCount, 0, (long long)size * size * size);
+	int threads = pool ? pool->getThreads() : 1;
+	floydBlocked(dist.data(), size, floydBlockSize(size, threads), pool);
 	
 	// Check for negative cycles
 	for (int i = 0; i < size; i++) {
-		if (dist[i][i] < 0) {
-			fout.close();
+		if (dist[(size_t)i * size + i] < 0) {
 			return false;
 		}
 	}
-	
-	// Print result
-	fout << "========FLOYD========" << endl;
+	return true;
+}
+
+// Header of the all-pairs result block, shared by Floyd and Johnson
+static void printAllPairsHeader(ostream* fout, char option, int size)
+{
+	*fout << "========FLOYD========" << '\n';
 	if (option == 'O') {
-		fout << "Directed Graph Floyd" << endl;
+		*fout << "Directed Graph Floyd" << '\n';
 	} else {
-		fout << "Undirected Graph Floyd" << endl;
+		*fout << "Undirected Graph Floyd" << '\n';
 	}
 	
 	// Print column headers
-	fout << "  ";
+	*fout << "  ";
 	for (int i = 0; i < size; i++) {
-		fout << "[" << i << "] ";
+		*fout << "[" << i << "] ";
 	}
-	fout << endl;
-	
-	// Print matrix
-	for (int i = 0; i < size; i++) {
-		fout << "[" << i << "] ";
-		for (int j = 0; j < size; j++) {
-			if (dist[i][j] == INT_MAX) {
-				fout << "x";
-			} else {
-				fout << dist[i][j];
-			}
-			if (j < size - 1) fout << " ";
+	*fout << '\n';
+}
+
+// One matrix row; entries equal to inf print as x
+template <typename T>
+static void printAllPairsRow(ostream* fout, int i, const T* row, int size, T inf)
+{
+	*fout << "[" << i << "] ";
+	for (int j = 0; j < size; j++) {
+		if (row[j] == inf) {
+			*fout << "x";
+		} else {
+			*fout << row[j];
 		}
-		fout << endl;
+		if (j < size - 1) *fout << " ";
 	}
-	fout << "====================" << endl << endl;
-	
-	fout.close();
+	*fout << '\n';
+}
+
+bool FloydMatrix(Graph* graph, char option, vector<int>* dist, ThreadPool* pool)
+{
+	// All-pairs distances in one contiguous matrix
+	return allPairsDistances(graph, option == 'O', *dist, pool);
+}
+
+void printFloyd(char option, int size, const vector<int>& dist, ostream* fout)
+{
+	// Print result
+	printAllPairsHeader(fout, option, size);
+	for (int i = 0; i < size; i++) {
+		printAllPairsRow(fout, i, &dist[(size_t)i * size], size, FLOYD_INF);
+	}
+	*fout << "====================" << '\n' << '\n';
+}
+
+bool FLOYD(Graph* graph, char option, ostream* fout, ThreadPool* pool)
+{
+	vector<int> dist;
+	if (!FloydMatrix(graph, option, &dist, pool)) {
+		return false;
+	}
+	printFloyd(option, graph->getSize(), dist, fout);
 	return true;
 }
 
-bool Centrality(Graph* graph) {
-	ofstream fout("log.txt", ios::app);
-	
+bool Johnson(Graph* graph, char option, ostream* fout, ThreadPool* pool)
+{
 	int size = graph->getSize();
+	bool direct = (option == 'O');
 	
-	// Use Floyd-Warshall to get all-pairs shortest paths (undirected)
-	vector<vector<int>> dist(size, vector<int>(size, INT_MAX));
+	// Scratch-backed spans cannot be shared between threads
+	if (!graph->hasStableSpans())
+		pool = nullptr;
 	
-	// Set diagonal to 0
-	for (int i = 0; i < size; i++) {
-		dist[i][i] = 0;
+	// Reweight once; the virtual-source Bellman-Ford also finds negative cycles
+	WeightProfile profile = profileWeights(graph, direct);
+	vector<long long> h;
+	if (profile.negative && !johnsonPotentials(graph, direct, false, &h)) {
+		return false;
 	}
+	const vector<long long>* potential = profile.negative ? &h : nullptr;
 	
-	// Fill in edge weights (undirected)
+	// Floyd starts the diagonal from a self-loop's weight, so a positive
+	// self-loop shows as the shortest cycle through its vertex, not 0
+	ScratchScope scratch;
+	int* selfLoop = scratch.take<int>(size, -1);
 	for (int i = 0; i < size; i++) {
-		map<int, int> edges;
-		graph->getAdjacentEdges(i, &edges);
-		
-		for (auto& edge : edges) {
-			dist[i][edge.first] = edge.second;
+		EdgeSpan edges = graph->getNeighbors(i, direct);
+		for (int k = 0; k < edges.count; k++) {
+			if (edges.to[k] == i) selfLoop[i] = edges.weight[k];
 		}
 	}
 	
-	// Floyd-Warshall algorithm
-	for (int k = 0; k < size; k++) {
-		for (int i = 0; i < size; i++) {
-			for (int j = 0; j < size; j++) {
-				if (dist[i][k] != INT_MAX && dist[k][j] != INT_MAX) {
-					if (dist[i][k] + dist[k][j] < dist[i][j]) {
-						dist[i][j] = dist[i][k] + dist[k][j];
-					}
+	// Rows are computed a chunk at a time in parallel and printed in order,
+	// so memory stays at chunk x V instead of V x V
+	int threads = pool ? pool->getThreads() : 1;
+	int chunk = (int)min<long long>(size, max<long long>(threads * 4LL, (1LL << 22) / max(size, 1)));
+	long long* rows = scratch.take<long long>((size_t)max(chunk, 1) * size);
+	
+	printAllPairsHeader(fout, option, size);
+	for (int first = 0; first < size; first += chunk) {
+		int count = min(chunk, size - first);
+		function<void(int)> computeRow = [&](int r) {
+			int i = first + r;
+			SsspWorkspace* ws = threadWorkspace();
+			shortestFrom(graph, direct, false, i, potential, profile.unit, ws);
+			long long* row = &rows[(size_t)r * size];
+			copy(ws->dist.begin(), ws->dist.end(), row);
+			
+			// Shortest cycle through i, closed by an edge k -> i
+			if (selfLoop[i] > 0) {
+				long long cycle = selfLoop[i];
+				EdgeSpan edges = graph->getReverseNeighbors(i, direct);
+				for (int k = 0; k < edges.count; k++) {
+					int from = edges.to[k];
+					if (from != i && row[from] != SSSP_INF && row[from] + edges.weight[k] < cycle)
+						cycle = row[from] + edges.weight[k];
 				}
+				row[i] = cycle;
 			}
+		};
+		if (pool) {
+			pool->parallelFor(count, computeRow);
+		} else {
+			for (int r = 0; r < count; r++) computeRow(r);
+		}
+		for (int r = 0; r < count; r++) {
+			printAllPairsRow(fout, first + r, &rows[(size_t)r * size], size, SSSP_INF);
 		}
 	}
+	*fout << "====================" << '\n' << '\n';
 	
-	// Check for negative cycles
-	for (int i = 0; i < size; i++) {
-		if (dist[i][i] < 0) {
-			fout.close();
-			return false;
+	return true;
+}
+
+// Distance sums into every vertex from the all-pairs matrix
+static bool denseDistanceSums(Graph* graph, long long* sums, char* unreachable, ThreadPool* pool)
+{
+	int size = graph->getSize();
+	
+	// Use Floyd-Warshall to get all-pairs shortest paths (undirected)
+	vector<int> dist;
+	if (!allPairsDistances(graph, false, dist, pool)) {
+		return false;
+	}
+	
+	// Each vertex's column sum is independent of the others
+	function<void(int)> columnSum = [&](int i) {
+		for (int j = 0; j < size; j++) {
+			if (i != j) {
+				if (dist[(size_t)j * size + i] == FLOYD_INF) {
+					unreachable[i] = 1;
+					break;
+				}
+				sums[i] += dist[(size_t)j * size + i];
+			}
 		}
+	};
+	if (pool) {
+		pool->parallelFor(size, columnSum);
+	} else {
+		for (int i = 0; i < size; i++) columnSum(i);
 	}
+	return true;
+}
+
+// Distance sums into every vertex from one single-source run per vertex
+// on the reverse graph, which gives the distances *to* that vertex
+static bool sparseDistanceSums(Graph* graph, const WeightProfile& profile, long long* sums,
+	char* unreachable, ThreadPool* pool)
+{
+	int size = graph->getSize();
 	
-	// Calculate closeness centrality for each vertex
-	vector<pair<double, int>> centrality(size);
+	// Negative edges: Johnson reweighting, which also finds negative cycles
+	vector<long long> h;
+	if (profile.negative && !johnsonPotentials(graph, false, true, &h)) {
+		return false;
+	}
+	const vector<long long>* potential = profile.negative ? &h : nullptr;
 	
-	for (int i = 0; i < size; i++) {
-		int sum = 0;
-		bool unreachable = false;
-		
-		// Sum distances from all other vertices to vertex i
+	// Runs are independent; each thread keeps one O(V) workspace
+	function<void(int)> sumInto = [&](int i) {
+		SsspWorkspace* ws = threadWorkspace();
+		shortestFrom(graph, false, true, i, potential, profile.unit, ws);
 		for (int j = 0; j < size; j++) {
 			if (i != j) {
-				if (dist[j][i] == INT_MAX) {
-					unreachable = true;
+				if (ws->dist[j] == SSSP_INF) {
+					unreachable[i] = 1;
 					break;
 				}
-				sum += dist[j][i];
+				sums[i] += ws->dist[j];
 			}
 		}
-		
-		if (unreachable || sum == 0) {
+	};
+	if (pool) {
+		pool->parallelFor(size, sumInto);
+	} else {
+		for (int i = 0; i < size; i++) sumInto(i);
+	}
+	return true;
+}
+
+bool Centrality(Graph* graph, ostream* fout, ThreadPool* pool) {
+	int size = graph->getSize();
+	
+	// Scratch-backed spans cannot be shared between threads
+	if (!graph->hasStableSpans())
+		pool = nullptr;
+	
+	// Sum of distances from all other vertices to each vertex. Sparse graphs
+	// use per-vertex shortest paths instead of a V x V matrix.
+	ScratchScope scratch;
+	long long* sums = scratch.take<long long>(size, 0);
+	char* unreachable = scratch.take<char>(size, 0);
+	WeightProfile profile = profileWeights(graph, false);
+	if (preferSparseAllPairs(graph, profile)) {
+		if (!sparseDistanceSums(graph, profile, sums, unreachable, pool)) {
+			return false;
+		}
+	} else {
+		if (!denseDistanceSums(graph, sums, unreachable, pool)) {
+			return false;
+		}
+	}
+	
+	// Calculate closeness centrality for each vertex
+	pair<double, int>* centrality = scratch.take<pair<double, int>>(size);
+	for (int i = 0; i < size; i++) {
+		if (unreachable[i] || sums[i] == 0) {
 			centrality[i] = {-1, i};  // Mark as unreachable
 		} else {
-			centrality[i] = {(double)(size - 1) / sum, i};
+			centrality[i] = {(double)(size - 1) / sums[i], i};
 		}
 	}
 	
@@ -581,30 +1370,23 @@ bool Centrality(Graph* graph) {
 	}
 	
 	// Print results
-	fout << "========CENTRALITY========" << endl;
+	*fout << "========CENTRALITY========" << '\n';
 	
 	for (int i = 0; i < size; i++) {
-		fout << "[" << i << "] ";
+		*fout << "[" << i << "] ";
 		
 		if (centrality[i].first < 0) {
-			fout << "x" << endl;
+			*fout << "x" << '\n';
 		} else {
-			int sum = 0;
-			for (int j = 0; j < size; j++) {
-				if (i != j && dist[j][i] != INT_MAX) {
-					sum += dist[j][i];
-				}
-			}
-			fout << (size - 1) << "/" << sum;
+			*fout << (size - 1) << "/" << sums[i];
 			
 			if (centrality[i].first == maxCentrality) {
-				fout << " <- Most Central";
+				*fout << " <- Most Central";
 			}
-			fout << endl;
+			*fout << '\n';
 		}
 	}
-	fout << "====================" << endl << endl;
+	*fout << "====================" << '\n' << '\n';
 	
-	fout.close();
 	return true;
 }
\ No newline at end of file
@@ -3,13 +3,37 @@
 
 #include "ListGraph.h"
 #include "MatrixGraph.h"
+#include "CsrGraph.h"
+#include "GraphLoader.h"
+#include "ThreadPool.h"
+#include "SparsePaths.h"
+#include "DynamicPaths.h"
 
-bool BFS(Graph* graph, char option, int vertex);     
-bool DFS(Graph* graph, char option,  int vertex);     
-bool Centrality(Graph* graph);  
-bool Kruskal(Graph* graph);
-bool Dijkstra(Graph* graph, char option, int vertex);    //Dijkstra
-bool Bellmanford(Graph* graph, char option, int s_vertex, int e_vertex); //Bellman - Ford
-bool FLOYD(Graph* graph, char option);   //FLoyd
+// Each algorithm writes its result block to fout (the Manager's log).
+// Algorithms taking a pool split their work across it; nullptr runs serially.
+bool BFS(Graph* graph, char option, int vertex, ostream* fout,
+	char mode = 'H', ThreadPool* pool = nullptr);	//BFS, mode 'Q'ueue or 'H'ybrid direction-optimizing
+bool BFSLevel(Graph* graph, char option, int vertex, ostream* fout, ThreadPool* pool = nullptr); //Levels only
+bool DFS(Graph* graph, char option,  int vertex, ostream* fout);     
+bool Centrality(Graph* graph, ostream* fout, ThreadPool* pool = nullptr);  
+bool Kruskal(Graph* graph, ostream* fout, char mode = 'K', ThreadPool* pool = nullptr);	//MST, mode 'K'ruskal or 'B'oruvka
+bool Dijkstra(Graph* graph, char option, int vertex, ostream* fout, char heap = 'A');    //Dijkstra, heap 'A'uto, 'I'ndexed, 'B'inary or 'D'ial
+bool DijkstraBatch(Graph* graph, char option, const vector<int>& sources, ostream* fout, char heap = 'A',
+	ThreadPool* pool = nullptr); //Dijkstra blocks for many sources, in order
+bool Bellmanford(Graph* graph, char option, int s_vertex, int e_vertex, ostream* fout,
+	char mode = 'E', ThreadPool* pool = nullptr); //Bellman - Ford, mode 'E'arly exit, 'S'PFA or 'P'arallel
+// Single-source halves of Dijkstra/Bellmanford: the tree (distances and
+// parents) and the printed block, so a kept tree can be printed again
+bool DijkstraTree(Graph* graph, char option, int vertex, vector<int>* dist, vector<int>* prev, char heap = 'A');
+void printDijkstra(char option, int vertex, const vector<int>& dist, const vector<int>& prev, ostream* fout);
+bool BellmanfordTree(Graph* graph, char option, int s_vertex, vector<int>* dist, vector<int>* prev,
+	char mode = 'E', ThreadPool* pool = nullptr);
+void printBellmanford(char option, int e_vertex, const vector<int>& dist, const vector<int>& prev, ostream* fout);
+bool Query(Graph* graph, char option, int s_vertex, int e_vertex, const QueryIndex* index, ostream* fout); //s -> e only
+bool FLOYD(Graph* graph, char option, ostream* fout, ThreadPool* pool = nullptr);   //FLoyd
+// FLOYD's halves: the V x V matrix, row-major, and the printed block
+bool FloydMatrix(Graph* graph, char option, vector<int>* dist, ThreadPool* pool = nullptr);
+void printFloyd(char option, int size, const vector<int>& dist, ostream* fout);
+bool Johnson(Graph* graph, char option, ostream* fout, ThreadPool* pool = nullptr); //Johnson, prints the FLOYD block
 
 #endif
\ No newline at end of file
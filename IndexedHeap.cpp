@@ -0,0 +1,125 @@
+#include "IndexedHeap.h"
+
+IndexedHeap::IndexedHeap()
+{
+	reset(0);
+}
+
+void IndexedHeap::reset(int capacity)
+{
+	m_Heap.clear();
+	m_Heap.reserve(capacity);
+	m_Queued.reset(capacity);
+	if ((int)m_Pos.size() < capacity) {
+		m_Pos.resize(capacity);
+		m_Key.resize(capacity);
+	}
+	m_Stats.pushes = 0;
+	m_Stats.pops = 0;
+	m_Stats.decreaseKeys = 0;
+	m_Stats.peak = 0;
+}
+
+bool IndexedHeap::before(int a, int b)
+{
+	// Ties on the key go to the smaller id
+	if (m_Key[a] != m_Key[b])
+		return m_Key[a] < m_Key[b];
+	return a < b;
+}
+
+void IndexedHeap::siftUp(int slot)
+{
+	// Move the entry up while it precedes its parent
+	int id = m_Heap[slot];
+	while (slot > 0) {
+		int parent = (slot - 1) / 4;
+		if (!before(id, m_Heap[parent]))
+			break;
+		m_Heap[slot] = m_Heap[parent];
+		m_Pos[m_Heap[slot]] = slot;
+		slot = parent;
+	}
+	m_Heap[slot] = id;
+	m_Pos[id] = slot;
+}
+
+void IndexedHeap::siftDown(int slot)
+{
+	// Move the entry down while one of its four children precedes it
+	int id = m_Heap[slot];
+	int count = (int)m_Heap.size();
+	while (true) {
+		int first = slot * 4 + 1;
+		if (first >= count)
+			break;
+		int best = first;
+		int last = first + 4 < count ? first + 4 : count;
+		for (int c = first + 1; c < last; c++) {
+			if (before(m_Heap[c], m_Heap[best]))
+				best = c;
+		}
+		if (!before(m_Heap[best], id))
+			break;
+		m_Heap[slot] = m_Heap[best];
+		m_Pos[m_Heap[slot]] = slot;
+		slot = best;
+	}
+	m_Heap[slot] = id;
+	m_Pos[id] = slot;
+}
+
+bool IndexedHeap::empty()
+{
+	return m_Heap.empty();
+}
+
+bool IndexedHeap::contains(int id)
+{
+	return m_Queued.test(id);
+}
+
+void IndexedHeap::push(int id, long long key)
+{
+	// Already queued: lower the key in place (keys only ever decrease)
+	if (m_Queued.test(id)) {
+		m_Key[id] = key;
+		siftUp(m_Pos[id]);
+		m_Stats.decreaseKeys++;
+		return;
+	}
+	
+	m_Queued.mark(id);
+	m_Key[id] = key;
+	m_Heap.push_back(id);
+	siftUp((int)m_Heap.size() - 1);
+	m_Stats.pushes++;
+	if ((int)m_Heap.size() > m_Stats.peak)
+		m_Stats.peak = (int)m_Heap.size();
+}
+
+int IndexedHeap::pop(long long* key)
+{
+	// Take the root and sift the last entry down from the top
+	int top = m_Heap[0];
+	*key = m_Key[top];
+	m_Queued.unmark(top);
+	int last = m_Heap.back();
+	m_Heap.pop_back();
+	if (!m_Heap.empty()) {
+		m_Heap[0] = last;
+		siftDown(0);
+	}
+	m_Stats.pops++;
+	return top;
+}
+
+long long IndexedHeap::topKey()
+{
+	return m_Key[m_Heap[0]];
+}
+
+HeapStats IndexedHeap::getStats()
+{
+	return m_Stats;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef _INDEXEDHEAP_H_
+#define _INDEXEDHEAP_H_
+
+#include "VisitMarks.h"
+#include <vector>
+
+using namespace std;
+
+// Operation counts of one heap over one run
+struct HeapStats{
+	long long pushes;	// New entries
+	long long pops;
+	long long decreaseKeys;	// Keys lowered in place
+	int peak;		// Largest number of entries at once
+};
+
+// 4-ary min-heap over vertex ids 0..V-1 with decrease-key.
+// Each id is stored at most once, so the heap never grows past V.
+// Entries are ordered by (key, id), the same order as a heap of pairs.
+// Reset is O(1) past the first use at a size: which ids are queued is
+// kept in epoch marks, so a short search never clears all V slots.
+class IndexedHeap{
+private:
+	vector<int> m_Heap;		// Ids in heap order
+	VisitMarks m_Queued;		// Ids currently in m_Heap
+	vector<int> m_Pos;		// Slot of each queued id in m_Heap
+	vector<long long> m_Key;	// Current key of each id
+	HeapStats m_Stats;
+
+	bool before(int a, int b);
+	void siftUp(int slot);
+	void siftDown(int slot);
+
+public:
+	IndexedHeap();
+
+	void reset(int capacity);
+	bool empty();
+	bool contains(int id);
+	void push(int id, long long key);
+	int pop(long long* key);
+	long long topKey();
+	HeapStats getStats();
+};
+
+#endif
\ No newline at end of file
@@ -6,6 +6,7 @@ ListGraph::ListGraph(bool type, int size) : Graph(type, size)
 {
 	// Allocate adjacency list for each vertex
 	m_List = new map<int, int>[size];
+	m_InList = new map<int, int>[size];
 }
 
 ListGraph::~ListGraph()	
@@ -13,6 +14,8 @@ ListGraph::~ListGraph()
 	// Deallocate adjacency list
 	if (m_List)
 		delete[] m_List;
+	if (m_InList)
+		delete[] m_InList;
 }
 
 void ListGraph::getAdjacentEdges(int vertex, map<int, int>* m)	 
@@ -21,10 +24,10 @@ void ListGraph::getAdjacentEdges(int vertex, map<int, int>* m)
 	// Copy edges from vertex's adjacency list
 	*m = m_List[vertex];
 	
-	// For undirected graph, also add reverse edges
-	for (int i = 0; i < m_Size; i++) {
-		if (i != vertex && m_List[i].find(vertex) != m_List[i].end()) {
-			(*m)[i] = m_List[i][vertex];
+	// For undirected graph, also add reverse edges from the incoming index
+	for (auto& edge : m_InList[vertex]) {
+		if (edge.first != vertex) {
+			(*m)[edge.first] = edge.second;
 		}
 	}
 }
@@ -40,9 +43,21 @@ void ListGraph::insertEdge(int from, int to, int weight)
 {
 	// Insert edge from 'from' to 'to' with given weight
 	m_List[from][to] = weight;
+	// Keep the incoming index in sync for undirected lookups
+	if (to >= 0 && to < m_Size)
+		m_InList[to][from] = weight;
 }
 
-bool ListGraph::printGraph(ofstream *fout)	
+bool ListGraph::deleteEdge(int from, int to)
+{
+	// Remove the edge from both the list and the incoming index
+	if (m_List[from].erase(to) == 0)
+		return false;
+	m_InList[to].erase(from);
+	return true;
+}
+
+bool ListGraph::printGraph(ostream *fout)	
 {
 	// Check if graph exists
 	if (m_Size <= 0)
@@ -56,8 +71,38 @@ bool ListGraph::printGraph(ofstream *fout)
 		for (auto& edge : m_List[i]) {
 			*fout << " -> (" << edge.first << "," << edge.second << ")";
 		}
-		*fout << endl;
+		*fout << '\n';
 	}
 	
 	return true;
+}
+
+EdgeSpan ListGraph::getReverseNeighbors(int vertex, bool direct)
+{
+	// Directed reverse range is exactly the incoming index
+	m_SpanTo.clear();
+	m_SpanWeight.clear();
+	if (direct) {
+		for (auto& edge : m_InList[vertex]) {
+			m_SpanTo.push_back(edge.first);
+			m_SpanWeight.push_back(edge.second);
+		}
+	} else {
+		// Undirected: u sees vertex through u's incoming edge from vertex
+		// when there is one, so the vertex's own outgoing weight wins here
+		map<int, int> edges = m_InList[vertex];
+		for (auto& edge : m_List[vertex]) {
+			edges[edge.first] = edge.second;
+		}
+		for (auto& edge : edges) {
+			m_SpanTo.push_back(edge.first);
+			m_SpanWeight.push_back(edge.second);
+		}
+	}
+	
+	EdgeSpan span;
+	span.to = m_SpanTo.data();
+	span.weight = m_SpanWeight.data();
+	span.count = (int)m_SpanTo.size();
+	return span;
 }
\ No newline at end of file
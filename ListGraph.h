@@ -6,6 +6,7 @@
 class ListGraph : public Graph{	
 private:
 	map<int, int>* m_List;  // Adjacency list for each vertex
+	map<int, int>* m_InList;  // Incoming edges for each vertex (source -> weight)
 	
 public:	
 	ListGraph(bool type, int size);
@@ -14,7 +15,9 @@ public:
 	void getAdjacentEdges(int vertex, map<int, int>* m);	
 	void getAdjacentEdgesDirect(int vertex, map<int, int>* m);
 	void insertEdge(int from, int to, int weight);	
-	bool printGraph(ofstream *fout);
+	bool deleteEdge(int from, int to);
+	bool printGraph(ostream *fout);
+	EdgeSpan getReverseNeighbors(int vertex, bool direct);
 };
 
 #endif
\ No newline at end of file
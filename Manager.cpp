@@ -1,336 +1,1107 @@
 #include "Manager.h"
 #include "GraphMethod.h"
+#include "ScratchArena.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <string>
 #include <sstream>
+#include <cstdlib>
+#include <climits>
 
 Manager::Manager()	
 {
 	graph = nullptr;	
+	csr = nullptr;
+	graphType = 'L';
 	fout.open("log.txt", ios::out | ios::trunc);  // Truncate mode to clear file
 	load = 0;	// Nothing is loaded initially
+	flushEvery = 1;	// Default policy: flush after every command, so a crash keeps the log so far
+	pool = new ThreadPool(max(1, (int)thread::hardware_concurrency()));	// One thread per core
+	pendingCommands = 0;
+	allPairs = 'A';	// Pick the FLOYD engine from the graph's density
+	bfsMode = 'H';
+	mstMode = 'K';
+	bellmanMode = 'E';
+	landmarks = 0;
+	queryIndex.negative = false;
+	queryIndex.landmarks = 0;
+	indexStale = false;
+	dijkstraHeap = 'A';	// Dial's buckets when the weights allow, else the indexed heap
+	verifySnapshots = false;	// Snapshots load in O(V), trusting what SAVE wrote
 	if (fout.is_open())
 		fout.close();  // Close immediately, reopen in run()
 }
 
 Manager::~Manager()
 {
-	if(load)	// If graph is loaded, delete graph to prevent memory leak
+	if(load) {	// If graph is loaded, delete graph to prevent memory leak
 		delete graph;	
+		delete csr;
+	}
 	if(fout.is_open())	// If output file is opened, close it
 		fout.close();	// Close log.txt file
+	delete pool;	// Join the worker threads
+}
+
+// Commands that only read the loaded graph and the result cache; a run of
+// them between other commands can execute side by side
+static bool isQuery(const string& command)
+{
+	return command == "BFS" || command == "BFSLEVEL" || command == "DFS" || command == "DIJKSTRA"
+		|| command == "BELLMANFORD" || command == "QUERY";
 }
 
 void Manager::run(const char* command_txt){
 	ifstream fin;	// Command file input stream
 	fin.open(command_txt, ios_base::in);  // Open command file in read mode
 		
+	// Give the log a large buffer so writes are not flushed line by line.
+	// The buffer has to be installed before the file is opened.
+	logBuffer.resize(1 << 20);
+	fout.rdbuf()->pubsetbuf(logBuffer.data(), logBuffer.size());
+	fout.open("log.txt", ios::app);  // Reopen in append mode
+	
 	if(!fin) {  // If command file cannot be opened, print error
-		ofstream fout("log.txt", ios::app);
-		fout << "command file open error" << endl;
+		fout << "command file open error" << '\n';
 		fout.close();
 		return;	
 	}
 	
-	fout.open("log.txt", ios::app);  // Reopen in append mode
+	// Reader: lines are read and split off their command word ahead of
+	// execution, and handed over in chunks to keep the queue off the
+	// per-command path
+	const size_t CHUNK = 256;
+	BoundedQueue<vector<CommandLine>> lines(256);
+	thread reader([&]() {
+		vector<CommandLine> chunk;
+		string line;
+		while (getline(fin, line)) {
+			if (line.empty()) continue;  // Skip empty lines
+			CommandLine entry;
+			istringstream iss(line);
+			iss >> entry.command;
+			entry.line = line;
+			chunk.push_back(entry);
+			if (chunk.size() == CHUNK) {
+				if (!lines.push(move(chunk)))
+					break;	// EXIT was reached
+				chunk.clear();
+			}
+		}
+		if (!chunk.empty())
+			lines.push(move(chunk));
+		lines.close();
+	});
+	vector<CommandLine> chunk;
+	size_t chunkAt = 0;
+	function<bool(CommandLine*)> nextLine = [&](CommandLine* entry) {
+		while (chunkAt == chunk.size()) {
+			if (!lines.pop(&chunk))
+				return false;
+			chunkAt = 0;
+		}
+		*entry = move(chunk[chunkAt++]);
+		return true;
+	};
+	
+	// Writer: blocks reach the log in command order
+	BoundedQueue<LogBlock> blocks(1 << 10);
+	thread writer([&]() {
+		LogBlock block;
+		while (blocks.pop(&block)) {
+			fout << block.text;
+			if (block.flush)
+				fout.flush();
+			blocks.done();
+		}
+	});
 	
-	string line;
-	// Read and process commands line by line
-	while (getline(fin, line)) {
-		if (line.empty()) continue;  // Skip empty lines
+	// A run of queries is split into batches that go out to the pool; any
+	// other command waits for the queries before it and runs alone, so
+	// LOAD, SET and the edge updates never overlap a query
+	vector<CommandLine> batch;
+	CommandLine entry;
+	bool more = nextLine(&entry);
+	bool exited = false;
+	while (more) {
+		if (entry.command == "EXIT") {
+			if (tracing()) {
+				CacheStats stats = cache.getStats();
+				cerr << "CACHE: " << stats.hits << " hits, " << stats.misses << " misses, "
+					<< stats.evictions << " evictions, " << stats.entries << " entries, "
+					<< stats.bytes << " bytes" << '\n';
+				ScratchStats arena = scratchStats();
+				cerr << "ARENA: " << arena.threads << " threads, " << arena.highWater / 1024 << " KB high-water, "
+					<< arena.largest / 1024 << " KB largest thread, " << arena.reserved / 1024 << " KB reserved, "
+					<< arena.grows << " block allocations" << '\n';
+			}
+			ostringstream out;
+			out << "========EXIT========" << '\n';
+			out << "Success" << '\n';
+			out << "====================" << '\n' << '\n';
+			writeBlock(&blocks, out.str(), false);
+			exited = true;
+			break;
+		}
 		
-		istringstream iss(line);
-		string command;
-		iss >> command;
+		batch.clear();
+		batch.push_back(entry);
+		more = nextLine(&entry);
+		// Queries run side by side only when the log is batched anyway;
+		// flushed per command, each one is on disk before the next starts
+		if (flushEvery != 1 && isQuery(batch[0].command)) {
+			size_t limit = (size_t)pool->getThreads() * 16;
+			while (more && isQuery(entry.command) && batch.size() < limit) {
+				batch.push_back(entry);
+				more = nextLine(&entry);
+			}
+		}
+		
+		if (batch.size() > 1) {
+			runQueries(batch, &blocks);
+			continue;
+		}
 		
-		// Process each command
-		if (command == "LOAD") {
-			string filename;
-			if (!(iss >> filename)) {
-				printErrorCode(100);
-			} else if (!LOAD(filename.c_str())) {
-				printErrorCode(100);
+		// Alone, a command may spread its own work over the pool
+		static thread_local ostringstream out;
+		out.str("");
+		CommandClock clock = metrics.start(true);
+		execute(batch[0], &out, pool);
+		metrics.record(batch[0].command, batch[0].line, metrics.stop(clock));
+		writeBlock(&blocks, out.str(), commandDone());
+	}
+	
+	// Stop the reader if EXIT left lines unread, then let the writer drain
+	lines.close();
+	reader.join();
+	blocks.close();
+	writer.join();
+	fout.close();  // Close output file
+	fin.close();
+	
+	// Prevent any further algorithm output
+	if (exited && load) {
+		delete graph;
+		delete csr;
+		graph = nullptr;
+		csr = nullptr;
+		load = 0;
+	}
+}
+
+void Manager::runQueries(const vector<CommandLine>& batch, BoundedQueue<LogBlock>* blocks)
+{
+	// Landmark tables left behind by an edge update are rebuilt before the
+	// queries share them
+	for (size_t i = 0; i < batch.size(); i++) {
+		if (batch[i].command == "QUERY" && indexStale && load && csr) {
+			buildQueryIndex(csr, landmarks, &queryIndex);
+			indexStale = false;
+		}
+	}
+	
+	// One query per pool index, each serial and into its own block
+	vector<string> texts(batch.size());
+	vector<CommandSample> samples(batch.size());
+	pool->parallelFor((int)batch.size(), [&](int i) {
+		// Named here, each worker gets its own buffer for all its queries
+		static thread_local ostringstream out;
+		out.str("");
+		CommandClock clock = metrics.start(false);
+		execute(batch[i], &out, nullptr);
+		samples[i] = metrics.stop(clock);
+		texts[i] = out.str();
+	});
+	
+	// The writer gets the batch as one block, flushed if any command's
+	// turn to flush fell inside it
+	string text;
+	bool flush = false;
+	for (size_t i = 0; i < batch.size(); i++) {
+		metrics.record(batch[i].command, batch[i].line, samples[i]);
+		text += texts[i];
+		if (commandDone())
+			flush = true;
+	}
+	writeBlock(blocks, text, flush);
+}
+
+void Manager::execute(const CommandLine& entry, ostream* out, ThreadPool* workers)
+{
+	istringstream iss(entry.line);
+	string command;
+	iss >> command;
+	
+	// Working arrays come from this thread's scratch arena and all go back
+	// when the command is done
+	ScratchScope scratch;
+	
+	// Process each command
+	if (command == "LOAD") {
+		string filename;
+		if (!(iss >> filename)) {
+			printErrorCode(100, out);
+		} else if (!LOAD(filename.c_str())) {
+			printErrorCode(100, out);
+		} else {
+			*out << "========LOAD========" << '\n';
+			*out << "Success" << '\n';
+			*out << "====================" << '\n' << '\n';
+		}
+	}
+	else if (command == "PRINT") {
+		if (!PRINT(out)) {
+			printErrorCode(200, out);
+		}
+	}
+	else if (command == "BFS") {
+		char option;
+		int vertex;
+		string extra;
+		if (!(iss >> option >> vertex) || (iss >> extra)) {
+			printErrorCode(300, out);
+		} else if (option != 'O' && option != 'X') {
+			printErrorCode(300, out);
+		} else if (!mBFS(option, vertex, out, workers)) {
+			printErrorCode(300, out);
+		}
+	}
+	else if (command == "BFSLEVEL") {
+		char option;
+		int vertex;
+		string extra;
+		if (!(iss >> option >> vertex) || (iss >> extra)) {
+			printErrorCode(1400, out);
+		} else if (option != 'O' && option != 'X') {
+			printErrorCode(1400, out);
+		} else if (!mBFSLEVEL(option, vertex, out, workers)) {
+			printErrorCode(1400, out);
+		}
+	}
+	else if (command == "DFS") {
+		char option;
+		int vertex;
+		string extra;
+		if (!(iss >> option >> vertex) || (iss >> extra)) {
+			printErrorCode(400, out);
+		} else if (option != 'O' && option != 'X') {
+			printErrorCode(400, out);
+		} else if (!mDFS(option, vertex, out)) {
+			printErrorCode(400, out);
+		}
+	}
+	else if (command == "KRUSKAL") {
+		string extra;
+		if (iss >> extra) {
+			printErrorCode(500, out);
+		} else if (!mKRUSKAL(out)) {
+			printErrorCode(500, out);
+		}
+	}
+	else if (command == "DIJKSTRA") {
+		char option;
+		int vertex;
+		string extra;
+		if (!(iss >> option >> vertex) || (iss >> extra)) {
+			printErrorCode(600, out);
+		} else if (option != 'O' && option != 'X') {
+			printErrorCode(600, out);
+		} else if (!mDIJKSTRA(option, vertex, out)) {
+			printErrorCode(600, out);
+		}
+	}
+	else if (command == "DIJKSTRA_BATCH") {
+		// Sources are listed after the option, or ALL for every vertex
+		char option;
+		string token;
+		vector<int> sources;
+		bool all = false, valid = true;
+		if (!(iss >> option)) {
+			valid = false;
+		}
+		while (valid && iss >> token) {
+			char* end;
+			long v = strtol(token.c_str(), &end, 10);
+			if (token == "ALL" && sources.empty() && !all) {
+				all = true;
+			} else if (!all && *end == '\0' && v >= 0 && v <= INT_MAX) {
+				sources.push_back((int)v);
 			} else {
-				fout << "========LOAD========" << endl;
-				fout << "Success" << endl;
-				fout << "====================" << endl << endl;
+				valid = false;
 			}
 		}
-		else if (command == "PRINT") {
-			if (!PRINT()) {
-				printErrorCode(200);
-			}
+		if (all && load && csr) {
+			for (int v = 0; v < csr->getSize(); v++) sources.push_back(v);
 		}
-		else if (command == "BFS") {
-			char option;
-			int vertex;
-			string extra;
-			if (!(iss >> option >> vertex) || (iss >> extra)) {
-				printErrorCode(300);
-			} else if (option != 'O' && option != 'X') {
-				printErrorCode(300);
-			} else if (!mBFS(option, vertex)) {
-				printErrorCode(300);
-			}
+		if (!valid || (sources.empty() && !all) || (option != 'O' && option != 'X')) {
+			printErrorCode(1300, out);
+		} else if (!mDIJKSTRA_BATCH(option, sources, out)) {
+			printErrorCode(1300, out);
 		}
-		else if (command == "DFS") {
-			char option;
-			int vertex;
-			string extra;
-			if (!(iss >> option >> vertex) || (iss >> extra)) {
-				printErrorCode(400);
-			} else if (option != 'O' && option != 'X') {
-				printErrorCode(400);
-			} else if (!mDFS(option, vertex)) {
-				printErrorCode(400);
-			}
+	}
+	else if (command == "BELLMANFORD") {
+		char option;
+		int s_vertex, e_vertex;
+		string extra;
+		if (!(iss >> option >> s_vertex >> e_vertex) || (iss >> extra)) {
+			printErrorCode(700, out);
+		} else if (option != 'O' && option != 'X') {
+			printErrorCode(700, out);
+		} else if (!mBELLMANFORD(option, s_vertex, e_vertex, out, workers)) {
+			printErrorCode(700, out);
 		}
-		else if (command == "KRUSKAL") {
-			string extra;
-			if (iss >> extra) {
-				printErrorCode(500);
-			} else if (!mKRUSKAL()) {
-				printErrorCode(500);
-			}
+	}
+	else if (command == "QUERY") {
+		char option;
+		int s_vertex, e_vertex;
+		string extra;
+		if (!(iss >> option >> s_vertex >> e_vertex) || (iss >> extra)) {
+			printErrorCode(1200, out);
+		} else if (option != 'O' && option != 'X') {
+			printErrorCode(1200, out);
+		} else if (!mQUERY(option, s_vertex, e_vertex, out)) {
+			printErrorCode(1200, out);
 		}
-		else if (command == "DIJKSTRA") {
-			char option;
-			int vertex;
-			string extra;
-			if (!(iss >> option >> vertex) || (iss >> extra)) {
-				printErrorCode(600);
-			} else if (option != 'O' && option != 'X') {
-				printErrorCode(600);
-			} else if (!mDIJKSTRA(option, vertex)) {
-				printErrorCode(600);
-			}
+	}
+	else if (command == "FLOYD") {
+		char option;
+		string extra;
+		if (!(iss >> option) || (iss >> extra)) {
+			printErrorCode(800, out);
+		} else if (option != 'O' && option != 'X') {
+			printErrorCode(800, out);
+		} else if (!mFLOYD(option, out)) {
+			printErrorCode(800, out);
 		}
-		else if (command == "BELLMANFORD") {
-			char option;
-			int s_vertex, e_vertex;
-			string extra;
-			if (!(iss >> option >> s_vertex >> e_vertex) || (iss >> extra)) {
-				printErrorCode(700);
-			} else if (option != 'O' && option != 'X') {
-				printErrorCode(700);
-			} else if (!mBELLMANFORD(option, s_vertex, e_vertex)) {
-				printErrorCode(700);
-			}
+	}
+	else if (command == "CENTRALITY") {
+		string extra;
+		if (iss >> extra) {
+			printErrorCode(900, out);
+		} else if (!mCentrality(out)) {
+			printErrorCode(900, out);
 		}
-		else if (command == "FLOYD") {
-			char option;
-			string extra;
-			if (!(iss >> option) || (iss >> extra)) {
-				printErrorCode(800);
-			} else if (option != 'O' && option != 'X') {
-				printErrorCode(800);
-			} else if (!mFLOYD(option)) {
-				printErrorCode(800);
-			}
+	}
+	else if (command == "SAVE") {
+		string filename, extra;
+		if (!(iss >> filename) || (iss >> extra)) {
+			printErrorCode(1100, out);
+		} else if (!SAVE(filename.c_str())) {
+			printErrorCode(1100, out);
+		} else {
+			*out << "========SAVE========" << '\n';
+			*out << "Success" << '\n';
+			*out << "====================" << '\n' << '\n';
 		}
-		else if (command == "CENTRALITY") {
-			string extra;
-			if (iss >> extra) {
-				printErrorCode(900);
-			} else if (!mCentrality()) {
-				printErrorCode(900);
-			}
+	}
+	else if (command == "SET") {
+		string key, value, extra;
+		if (!(iss >> key >> value) || (iss >> extra)) {
+			printErrorCode(1000, out);
+		} else if (!SET(key, value)) {
+			printErrorCode(1000, out);
+		} else {
+			*out << "========SET========" << '\n';
+			*out << key << " " << value << '\n';
+			*out << "====================" << '\n' << '\n';
 		}
-		else if (command == "EXIT") {
-			fout << "========EXIT========" << endl;
-			fout << "Success" << endl;
-			fout << "====================" << endl << endl;
-			fout.close();  // Close output file
-			fin.close();
-			
-			// Prevent any further algorithm output
-			if (graph) {
-				delete graph;
-				graph = nullptr;
-				load = 0;
-			}
-			return;  // Exit immediately
+	}
+	else if (command == "INSERT_EDGE") {
+		int from, to, weight;
+		string extra;
+		if (!(iss >> from >> to >> weight) || (iss >> extra)) {
+			printErrorCode(1600, out);
+		} else if (!mINSERT_EDGE(from, to, weight)) {
+			printErrorCode(1600, out);
+		} else {
+			*out << "========INSERT_EDGE========" << '\n';
+			*out << "Success" << '\n';
+			*out << "====================" << '\n' << '\n';
+		}
+	}
+	else if (command == "DELETE_EDGE") {
+		int from, to;
+		string extra;
+		if (!(iss >> from >> to) || (iss >> extra)) {
+			printErrorCode(1700, out);
+		} else if (!mDELETE_EDGE(from, to)) {
+			printErrorCode(1700, out);
+		} else {
+			*out << "========DELETE_EDGE========" << '\n';
+			*out << "Success" << '\n';
+			*out << "====================" << '\n' << '\n';
+		}
+	}
+	else if (command == "UPDATE_WEIGHT") {
+		int from, to, weight;
+		string extra;
+		if (!(iss >> from >> to >> weight) || (iss >> extra)) {
+			printErrorCode(1800, out);
+		} else if (!mUPDATE_WEIGHT(from, to, weight)) {
+			printErrorCode(1800, out);
+		} else {
+			*out << "========UPDATE_WEIGHT========" << '\n';
+			*out << "Success" << '\n';
+			*out << "====================" << '\n' << '\n';
+		}
+	}
+	else if (command == "STATS") {
+		string extra;
+		if (iss >> extra) {
+			printErrorCode(1500, out);
+		} else {
+			metrics.print(out, cache.getStats());
 		}
 	}
-	
-	fout.close();  // Close at end
-	fin.close();
-	return;
 }
 
 bool Manager::LOAD(const char* filename)
 {
-	ifstream fin(filename);
+	GraphFile* file = new GraphFile;
 	
-	// Check if file exists and can be opened
-	if (!fin) {
+	// Check if file exists and can be mapped
+	if (!file->open(filename)) {
+		delete file;
 		return false;
 	}
 	
+	// Results kept for the old graph no longer apply
+	cache.clear();
+	
 	// If graph already exists, delete it and create new one
 	if (load) {
 		delete graph;
+		delete csr;
 		graph = nullptr;
+		csr = nullptr;
 		load = 0;
 	}
 	
-	char type;
-	int size;
+	// A binary snapshot is used in place; the graph takes over the mapping
+	if (CsrGraph::isSnapshot(file)) {
+		csr = CsrGraph::openSnapshot(file, &graphType, verifySnapshots);
+		if (!csr) {
+			delete file;
+			return false;
+		}
+		if (tracing()) {
+			cerr << "LOAD " << filename << ": snapshot, " << file->getBytes() << " bytes mapped, "
+				<< csr->getEdgeCount() << " edges" << '\n';
+		}
+		buildQueryIndex(csr, landmarks, &queryIndex);
+		indexStale = false;
+		load = 1;  // Mark graph as loaded
+		return true;
+	}
 	
-	// Read graph type (L for List, M for Matrix) and number of vertices
-	fin >> type >> size;
+	// Parse the mapped bytes into a flat edge list
+	EdgeList edges;
+	if (!file->parse(&edges)) {
+		delete file;
+		return false;
+	}
 	
-	bool isDirected = true;  // Default graph type
+	// Build the flat copy straight from the edge list, sorted and deduplicated.
+	// The ListGraph/MatrixGraph for PRINT is only built when it is needed.
+	csr = new CsrGraph(edges);
+	graphType = edges.type;
 	
-	// Create appropriate graph type based on input
-	if (type == 'L') {
-		graph = new ListGraph(isDirected, size);
-		
-		// Read adjacency list format
-		string line;
-		getline(fin, line);  // Skip remaining characters on first line
-		
-		for (int from = 0; from < size; from++) {
-			if (!getline(fin, line)) break;
-			
-			// Parse vertex number line (just vertex index)
-			istringstream vss(line);
-			int vertex_num;
-			if (!(vss >> vertex_num)) continue;
-			
-			// Read next line for edges
-			if (!getline(fin, line)) break;
-			istringstream ess(line);
-			
-			int to, weight;
-			// Read all edges for this vertex
-			while (ess >> to >> weight) {
-				graph->insertEdge(from, to, weight);
-			}
+	// Report parse throughput on stderr so log.txt is unaffected
+	if (tracing()) {
+		double seconds = file->getSeconds();
+		double mbps = (seconds > 0) ? file->getBytes() / seconds / 1e6 : 0;
+		cerr << "LOAD " << filename << ": " << file->getBytes() << " bytes, "
+			<< edges.from.size() << " edges parsed in " << seconds * 1000 << " ms ("
+			<< mbps << " MB/s)" << '\n';
+	}
+	
+	delete file;
+	buildQueryIndex(csr, landmarks, &queryIndex);
+	indexStale = false;
+	load = 1;  // Mark graph as loaded
+	return true;
+}
+
+bool Manager::SAVE(const char* filename)
+{
+	// Check if graph is loaded
+	if (!load || !csr) {
+		return false;
+	}
+	
+	// Write the CSR arrays out as a binary snapshot
+	return csr->saveSnapshot(filename, graphType);
+}
+
+Graph* Manager::getGraph()
+{
+	// Build the ListGraph/MatrixGraph from the CSR rows on first use
+	if (!graph && csr) {
+		bool isDirected = true;  // Default graph type
+		int size = csr->getSize();
+		if (graphType == 'L') {
+			graph = new ListGraph(isDirected, size);
+		} else {
+			graph = new MatrixGraph(isDirected, size);
 		}
-	} 
-	else if (type == 'M') {
-		graph = new MatrixGraph(isDirected, size);
 		
-		// Read adjacency matrix format
 		for (int i = 0; i < size; i++) {
-			for (int j = 0; j < size; j++) {
-				int weight;
-				fin >> weight;
-				if (weight != 0) {  // Only insert non-zero weights
-					graph->insertEdge(i, j, weight);
-				}
+			EdgeSpan span = csr->getNeighbors(i, true);
+			for (int k = 0; k < span.count; k++) {
+				graph->insertEdge(i, span.to[k], span.weight[k]);
 			}
 		}
-	} 
-	else {
-		fin.close();
-		return false;
 	}
-	
-	fin.close();
-	load = 1;  // Mark graph as loaded
-	return true;
+	return graph;
 }
 
-bool Manager::PRINT()	
+bool Manager::PRINT(ostream* out)	
 {
 	// Check if graph is loaded
-	if (!load || !graph) {
+	if (!load || !csr) {
 		return false;
 	}
 	
 	// Print graph structure
-	fout << "========PRINT========" << endl;
-	graph->printGraph(&fout);
-	fout << "====================" << endl << endl;
+	*out << "========PRINT========" << '\n';
+	getGraph()->printGraph(out);
+	*out << "====================" << '\n' << '\n';
 	
 	return true;
 }
 
-bool Manager::mBFS(char option, int vertex)	
+bool Manager::mBFS(char option, int vertex, ostream* out, ThreadPool* workers)	
 {
 	// Validate graph and vertex
-	if (!load || !graph || vertex < 0 || vertex >= graph->getSize()) {
+	if (!load || !csr || vertex < 0 || vertex >= csr->getSize()) {
 		return false;
 	}
 	
 	// Call BFS algorithm
-	return BFS(graph, option, vertex);
+	return cachedRun(string("BFS ") + option + " " + to_string(vertex), out, [&](ostream* block) {
+		return BFS(csr, option, vertex, block, bfsMode, workers);
+	});
+}
+
+bool Manager::mBFSLEVEL(char option, int vertex, ostream* out, ThreadPool* workers)
+{
+	// Validate graph and vertex
+	if (!load || !csr || vertex < 0 || vertex >= csr->getSize()) {
+		return false;
+	}
+	
+	// Levels without the visit order, so any direction can stop early
+	return cachedRun(string("BFSLEVEL ") + option + " " + to_string(vertex), out, [&](ostream* block) {
+		return BFSLevel(csr, option, vertex, block, workers);
+	});
 }
 
-bool Manager::mDFS(char option, int vertex)	
+bool Manager::mDFS(char option, int vertex, ostream* out)	
 {
 	// Validate graph and vertex
-	if (!load || !graph || vertex < 0 || vertex >= graph->getSize()) {
+	if (!load || !csr || vertex < 0 || vertex >= csr->getSize()) {
 		return false;
 	}
 	
 	// Call DFS algorithm
-	return DFS(graph, option, vertex);
+	return cachedRun(string("DFS ") + option + " " + to_string(vertex), out, [&](ostream* block) {
+		return DFS(csr, option, vertex, block);
+	});
 }
 
-bool Manager::mDIJKSTRA(char option, int vertex)	
+bool Manager::mDIJKSTRA(char option, int vertex, ostream* out)	
 {
 	// Validate graph and vertex
-	if (!load || !graph || vertex < 0 || vertex >= graph->getSize()) {
+	if (!load || !csr || vertex < 0 || vertex >= csr->getSize()) {
 		return false;
 	}
 	
-	// Call Dijkstra algorithm
-	return Dijkstra(graph, option, vertex);
+	if (!cache.enabled()) {
+		return Dijkstra(csr, option, vertex, out, dijkstraHeap);
+	}
+	
+	// The tree from this source is kept, so a repeat only prints it
+	string key = string("DIJKSTRA ") + option + " " + to_string(vertex);
+	bool ok;
+	static thread_local vector<int> newDist, newPrev;
+	if (findTree(key, &ok, &newDist, &newPrev)) {
+		if (ok)
+			printDijkstra(option, vertex, newDist, newPrev, out);
+		return ok;
+	}
+	ok = DijkstraTree(csr, option, vertex, &newDist, &newPrev, dijkstraHeap);
+	if (ok)
+		printDijkstra(option, vertex, newDist, newPrev, out);
+	storeTree(key, ok, newDist, newPrev);
+	return ok;
 }
 
-bool Manager::mKRUSKAL()
+bool Manager::mDIJKSTRA_BATCH(char option, const vector<int>& sources, ostream* out)
+{
+	// Validate graph and every source before running any of them
+	if (!load || !csr) {
+		return false;
+	}
+	for (size_t i = 0; i < sources.size(); i++) {
+		if (sources[i] >= csr->getSize()) {
+			return false;
+		}
+	}
+	
+	// All sources at once across the pool
+	return DijkstraBatch(csr, option, sources, out, dijkstraHeap, pool);
+}
+
+bool Manager::mKRUSKAL(ostream* out)
 {
 	// Check if graph is loaded
-	if (!load || !graph) {
+	if (!load || !csr) {
 		return false;
 	}
 	
 	// Call Kruskal algorithm
-	return Kruskal(graph);
+	return cachedRun("KRUSKAL", out, [&](ostream* block) {
+		return Kruskal(csr, block, mstMode, pool);
+	});
+}
+
+bool Manager::mBELLMANFORD(char option, int s_vertex, int e_vertex, ostream* out, ThreadPool* workers)
+{
+	// Validate graph and vertices
+	if (!load || !csr || s_vertex < 0 || s_vertex >= csr->getSize() 
+		|| e_vertex < 0 || e_vertex >= csr->getSize()) {
+		return false;
+	}
+	
+	if (!cache.enabled()) {
+		return Bellmanford(csr, option, s_vertex, e_vertex, out, bellmanMode, workers);
+	}
+	
+	// The tree from s_vertex is kept, so any later end vertex is answered
+	// from it. The mode is part of the key since modes may differ on ties.
+	string key = string("BELLMANFORD ") + option + " " + to_string(s_vertex) + " " + bellmanMode;
+	bool ok;
+	static thread_local vector<int> newDist, newPrev;
+	if (findTree(key, &ok, &newDist, &newPrev)) {
+		if (ok)
+			printBellmanford(option, e_vertex, newDist, newPrev, out);
+		return ok;
+	}
+	ok = BellmanfordTree(csr, option, s_vertex, &newDist, &newPrev, bellmanMode, workers);
+	if (ok)
+		printBellmanford(option, e_vertex, newDist, newPrev, out);
+	storeTree(key, ok, newDist, newPrev);
+	return ok;
 }
 
-bool Manager::mBELLMANFORD(char option, int s_vertex, int e_vertex) 
+bool Manager::mQUERY(char option, int s_vertex, int e_vertex, ostream* out)
 {
 	// Validate graph and vertices
-	if (!load || !graph || s_vertex < 0 || s_vertex >= graph->getSize() 
-		|| e_vertex < 0 || e_vertex >= graph->getSize()) {
+	if (!load || !csr || s_vertex < 0 || s_vertex >= csr->getSize()
+		|| e_vertex < 0 || e_vertex >= csr->getSize()) {
 		return false;
 	}
 	
-	// Call Bellman-Ford algorithm
-	return Bellmanford(graph, option, s_vertex, e_vertex);
+	// Landmark tables left behind by an edge update are rebuilt first
+	if (indexStale) {
+		buildQueryIndex(csr, landmarks, &queryIndex);
+		indexStale = false;
+	}
+	
+	// Bidirectional Dijkstra, guided by the landmarks if there are any
+	string key = string("QUERY ") + option + " " + to_string(s_vertex) + " " + to_string(e_vertex);
+	return cachedRun(key, out, [&](ostream* block) {
+		return Query(csr, option, s_vertex, e_vertex, &queryIndex, block);
+	});
 }
 
-bool Manager::mFLOYD(char option)
+bool Manager::mFLOYD(char option, ostream* out)
 {
 	// Check if graph is loaded
-	if (!load || !graph) {
+	if (!load || !csr) {
 		return false;
 	}
 	
-	// Call Floyd-Warshall algorithm
-	return FLOYD(graph, option);
+	// Johnson's algorithm when the graph is sparse, Floyd-Warshall otherwise
+	bool sparse;
+	if (allPairs == 'A') {
+		sparse = preferSparseAllPairs(csr, profileWeights(csr, option == 'O'));
+	} else {
+		sparse = (allPairs == 'J');
+	}
+	if (sparse) {
+		return cachedRun(string("FLOYD ") + option, out, [&](ostream* block) {
+			return Johnson(csr, option, block, pool);
+		});
+	}
+	if (!cache.enabled()) {
+		return FLOYD(csr, option, out, pool);
+	}
+	
+	// Floyd-Warshall's matrix is kept instead of the block, so an edge
+	// update can patch it
+	string key = string("FLOYD ") + option + " MATRIX";
+	bool ok;
+	const vector<int>* dist;
+	const vector<int>* prev;
+	if (cache.findTree(key, &ok, &dist, &prev)) {
+		if (ok)
+			printFloyd(option, csr->getSize(), *dist, out);
+		return ok;
+	}
+	vector<int> matrix;
+	ok = FloydMatrix(csr, option, &matrix, pool);
+	if (ok) {
+		printFloyd(option, csr->getSize(), matrix, out);
+	} else {
+		matrix.clear();	// Nothing to patch past a negative cycle
+	}
+	cache.storeTree(key, ok, matrix, vector<int>());
+	return ok;
 }
 
-bool Manager::mCentrality() {
+bool Manager::mCentrality(ostream* out) {
 	// Check if graph is loaded
-	if (!load || !graph) {
+	if (!load || !csr) {
 		return false;
 	}
 	
 	// Call Centrality calculation
-	return Centrality(graph);
+	return cachedRun("CENTRALITY", out, [&](ostream* block) {
+		return Centrality(csr, block, pool);
+	});
+}
+
+bool Manager::mINSERT_EDGE(int from, int to, int weight)
+{
+	// Validate graph and vertices; the edge must not exist yet
+	int current;
+	if (!load || !csr || from < 0 || from >= csr->getSize() || to < 0 || to >= csr->getSize()
+		|| csr->findEdge(from, to, true, &current)) {
+		return false;
+	}
+	
+	// A 0 in a matrix graph means there is no edge, so it cannot be stored
+	if (graphType == 'M' && weight == 0) {
+		return false;
+	}
+	
+	applyEdge(from, to, true, weight);
+	return true;
+}
+
+bool Manager::mDELETE_EDGE(int from, int to)
+{
+	// Validate graph and vertices; the edge must exist
+	int current;
+	if (!load || !csr || from < 0 || from >= csr->getSize() || to < 0 || to >= csr->getSize()
+		|| !csr->findEdge(from, to, true, &current)) {
+		return false;
+	}
+	
+	applyEdge(from, to, false, 0);
+	return true;
+}
+
+bool Manager::mUPDATE_WEIGHT(int from, int to, int weight)
+{
+	// Validate graph and vertices; the edge must exist
+	int current;
+	if (!load || !csr || from < 0 || from >= csr->getSize() || to < 0 || to >= csr->getSize()
+		|| !csr->findEdge(from, to, true, &current)) {
+		return false;
+	}
+	
+	// A 0 in a matrix graph means there is no edge; DELETE_EDGE removes one
+	if (graphType == 'M' && weight == 0) {
+		return false;
+	}
+	
+	applyEdge(from, to, true, weight);
+	return true;
+}
+
+void Manager::applyEdge(int from, int to, bool present, int weight)
+{
+	// Note the view entries the update can touch, then update both graphs
+	vector<EdgeChange> changes[2];
+	watchEdge(csr, from, to, changes);
+	if (present) {
+		csr->insertEdge(from, to, weight);
+		if (graph) graph->insertEdge(from, to, weight);
+	} else {
+		csr->deleteEdge(from, to);
+		if (graph) graph->deleteEdge(from, to);
+	}
+	settleEdge(csr, changes);
+	if (changes[0].empty() && changes[1].empty()) {
+		return;
+	}
+	
+	// Landmark distances may no longer be lower bounds
+	indexStale = true;
+	
+	// Dijkstra trees and FLOYD matrices are patched in place. Bellman-Ford
+	// parents depend on the pass order and printed blocks cannot be
+	// patched, so those are dropped.
+	WeightProfile profile[2];
+	bool profiled[2] = {false, false};
+	cache.patch([&](const string& key, bool* ok, vector<int>* dist, vector<int>* prev) {
+		istringstream iss(key);
+		string command, kind;
+		char option;
+		int source;
+		iss >> command >> option;
+		int view = (option == 'O') ? 1 : 0;
+		if (command == "DIJKSTRA" && *ok && (iss >> source)) {
+			if (!profiled[view]) {
+				profile[view] = profileWeights(csr, view == 1);
+				profiled[view] = true;
+			}
+			return updateDijkstraTree(csr, view == 1, source, changes[view], profile[view], dist, prev);
+		}
+		if (command == "FLOYD" && (iss >> kind) && kind == "MATRIX") {
+			return updateAllPairs(csr->getSize(), changes[view], dist, ok, pool);
+		}
+		return false;
+	});
+}
+
+bool Manager::SET(const string& key, const string& value)
+{
+	// FLUSH takes COMMAND (the default), a positive command count, or EXIT
+	// to batch the whole log until the end
+	if (key == "FLUSH") {
+		if (value == "EXIT") {
+			flushEvery = 0;
+		} else if (value == "COMMAND") {
+			flushEvery = 1;
+		} else {
+			int n = atoi(value.c_str());
+			if (n <= 0)
+				return false;
+			flushEvery = n;
+		}
+		return true;
+	}
+	
+	// THREADS sets the worker count for the parallel algorithms, at most
+	// four per core since each one is a thread started up front
+	if (key == "THREADS") {
+		long n = strtol(value.c_str(), nullptr, 10);
+		long most = max(1, (int)thread::hardware_concurrency()) * 4L;
+		if (n <= 0 || n > most)
+			return false;
+		delete pool;
+		pool = new ThreadPool(n);
+		return true;
+	}
+	
+	// ALLPAIRS picks the FLOYD engine: AUTO, FLOYD or JOHNSON
+	if (key == "ALLPAIRS") {
+		if (value == "AUTO") {
+			allPairs = 'A';
+		} else if (value == "FLOYD") {
+			allPairs = 'F';
+		} else if (value == "JOHNSON") {
+			allPairs = 'J';
+		} else {
+			return false;
+		}
+		return true;
+	}
+	
+	// HEAP picks the DIJKSTRA queue: AUTO, INDEXED, BINARY or DIAL
+	if (key == "HEAP") {
+		if (value == "AUTO") {
+			dijkstraHeap = 'A';	// Dial's buckets when the weights allow, else the indexed heap
+		} else if (value == "DIAL") {
+			dijkstraHeap = 'D';
+		} else if (value == "INDEXED") {
+			dijkstraHeap = 'I';
+		} else if (value == "BINARY") {
+			dijkstraHeap = 'B';
+		} else {
+			return false;
+		}
+		return true;
+	}
+	
+	// BELLMAN picks the BELLMANFORD mode: PASSES, SPFA or PARALLEL
+	if (key == "BELLMAN") {
+		if (value == "PASSES") {
+			bellmanMode = 'E';
+		} else if (value == "SPFA") {
+			bellmanMode = 'S';
+		} else if (value == "PARALLEL") {
+			bellmanMode = 'P';
+		} else {
+			return false;
+		}
+		return true;
+	}
+	
+	// LANDMARKS sets how many ALT landmarks QUERY uses, 0 to 64. The tables
+	// are built at LOAD, or right away if a graph is already loaded.
+	if (key == "LANDMARKS") {
+		int n = atoi(value.c_str());
+		if (n < 0 || n > 64 || (n == 0 && value != "0"))
+			return false;
+		landmarks = n;
+		if (load && csr) {
+			buildQueryIndex(csr, landmarks, &queryIndex);
+			indexStale = false;
+			cache.clear();	// Kept QUERY paths may differ on ties
+		}
+		return true;
+	}
+	
+	// CACHE sets the result cache limit in MB; 0 turns it off
+	if (key == "CACHE") {
+		int n = atoi(value.c_str());
+		if (n < 0 || (n == 0 && value != "0"))
+			return false;
+		cache.setLimit((size_t)n << 20);
+		return true;
+	}
+	
+	// BFS picks the BFS engine: HYBRID or QUEUE, both print the same order
+	if (key == "BFS") {
+		if (value == "HYBRID") {
+			bfsMode = 'H';
+		} else if (value == "QUEUE") {
+			bfsMode = 'Q';
+		} else {
+			return false;
+		}
+		return true;
+	}
+	
+	// MST picks the KRUSKAL engine: KRUSKAL or BORUVKA, same output
+	if (key == "MST") {
+		if (value == "KRUSKAL") {
+			mstMode = 'K';
+		} else if (value == "BORUVKA") {
+			mstMode = 'B';
+		} else {
+			return false;
+		}
+		return true;
+	}
+	
+	// VERIFY ON checksums every snapshot LOAD and checks each row's
+	// targets; OFF (the default) only checks the header and offsets
+	if (key == "VERIFY") {
+		if (value == "ON") {
+			verifySnapshots = true;
+		} else if (value == "OFF") {
+			verifySnapshots = false;
+		} else {
+			return false;
+		}
+		return true;
+	}
+	
+	// TRACE ON writes per-command diagnostics to stderr, OFF (the default)
+	// stops them
+	if (key == "TRACE") {
+		if (value == "ON") {
+			setTrace(true);
+		} else if (value == "OFF") {
+			setTrace(false);
+		} else {
+			return false;
+		}
+		return true;
+	}
+	
+	// METRICS writes a cost line per command to a file, OFF stops it
+	if (key == "METRICS") {
+		return metrics.setTrailer(value);
+	}
+	
+	// Unknown setting
+	return false;
+}
+
+bool Manager::commandDone()
+{
+	// Apply the flush policy: true when the log is flushed after this
+	// command's block
+	pendingCommands++;
+	if (flushEvery > 0 && pendingCommands >= flushEvery) {
+		pendingCommands = 0;
+		return true;
+	}
+	return false;
+}
+
+void Manager::writeBlock(BoundedQueue<LogBlock>* blocks, string text, bool flush)
+{
+	LogBlock block;
+	block.text = move(text);
+	block.flush = flush;
+	blocks->push(move(block));
+	
+	// A flushed block is on disk before the next command starts, so a
+	// crash in that command still leaves the log up to here
+	if (flush)
+		blocks->drain();
+}
+
+bool Manager::cachedRun(const string& key, ostream* out, const function<bool(ostream*)>& compute)
+{
+	if (!cache.enabled()) {
+		return compute(out);
+	}
+	
+	// A repeated command prints the block it printed last time
+	bool ok;
+	{
+		lock_guard<mutex> lock(cacheLock);
+		const string* text;
+		if (cache.findText(key, &ok, &text)) {
+			*out << *text;
+			return ok;
+		}
+	}
+	
+	// Otherwise run it into this thread's buffer, then log and keep the block
+	static thread_local ostringstream buffer;
+	buffer.str("");
+	ok = compute(&buffer);
+	string block = buffer.str();
+	*out << block;
+	lock_guard<mutex> lock(cacheLock);
+	cache.storeText(key, ok, block);
+	return ok;
+}
+
+bool Manager::findTree(const string& key, bool* ok, vector<int>* dist, vector<int>* prev)
+{
+	// Copied out, since another query may evict the entry
+	lock_guard<mutex> lock(cacheLock);
+	const vector<int>* keptDist;
+	const vector<int>* keptPrev;
+	if (!cache.findTree(key, ok, &keptDist, &keptPrev)) {
+		return false;
+	}
+	*dist = *keptDist;
+	*prev = *keptPrev;
+	return true;
+}
+
+void Manager::storeTree(const string& key, bool ok, const vector<int>& dist, const vector<int>& prev)
+{
+	lock_guard<mutex> lock(cacheLock);
+	cache.storeTree(key, ok, dist, prev);
 }
 
-void Manager::printErrorCode(int n)
+void Manager::printErrorCode(int n, ostream* out)
 {
 	// Print error code in specified format
-	fout << "========ERROR========" << endl;
-	fout << n << endl;
-	fout << "====================" << endl << endl;
+	*out << "========ERROR========" << '\n';
+	*out << n << '\n';
+	*out << "====================" << '\n' << '\n';
 }
\ No newline at end of file
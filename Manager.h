@@ -2,29 +2,68 @@
 #define _MANAGER_H_
 
 #include "GraphMethod.h"
+#include "ResultCache.h"
+#include "Metrics.h"
+#include "Pipeline.h"
 
 class Manager{	
 private:
-	Graph* graph;	
-	ofstream fout;	
+	Graph* graph;	// ListGraph/MatrixGraph for PRINT, built on first use
+	CsrGraph* csr;	// Flat graph that the algorithms traverse
+	char graphType;	// 'L' or 'M', the format the graph was loaded in
+	vector<char> logBuffer;	// User-space buffer behind fout, must outlive it
+	ofstream fout;	// Only the writer thread touches it while run() is going
+	int flushEvery;	// Flush log every N commands, 0 = only at EXIT; 1 also runs queries one by one
+	int pendingCommands;	// Commands written since the last flush
 	int load;
+	ThreadPool* pool;	// Workers shared by the parallel algorithms
+	char allPairs;	// FLOYD engine: 'A'uto, 'F'loyd-Warshall or 'J'ohnson
+	char bfsMode;	// BFS: 'H'ybrid direction-optimizing or plain 'Q'ueue
+	char mstMode;	// KRUSKAL engine: radix-sorted 'K'ruskal or parallel 'B'oruvka
+	char bellmanMode;	// BELLMANFORD: 'E'arly-exit passes, 'S'PFA worklist or 'P'arallel rounds
+	int landmarks;	// ALT landmarks QUERY precomputes at LOAD, 0 = none
+	QueryIndex queryIndex;	// Landmark tables of the loaded graph
+	bool indexStale;	// An edge update came after queryIndex was built
+	ResultCache cache;	// Results for the loaded graph, cleared by LOAD
+	mutex cacheLock;	// Guards cache while queries run side by side
+	char dijkstraHeap;	// DIJKSTRA queue: 'A'uto, 'I'ndexed 4-ary, 'B'inary or 'D'ial's buckets
+	CommandMetrics metrics;	// Cost of every command run, for STATS
+	bool verifySnapshots;	// LOAD checks a snapshot's whole payload, not just its offsets
 
 public:
 	Manager();	
 	~Manager();	
 
 	void run(const char * command_txt);
+	void runQueries(const vector<CommandLine>& batch, BoundedQueue<LogBlock>* blocks);
+	void execute(const CommandLine& entry, ostream* out, ThreadPool* workers);
 	
 	bool LOAD(const char* filename);	
-	bool PRINT();	
-	bool mBFS(char option, int vertex);	
-	bool mDFS(char option, int vertex);	
-	bool mDIJKSTRA(char option, int vertex);	
-	bool mKRUSKAL();	
-	bool mBELLMANFORD(char option, int s_vertex, int e_vertex);	
-	bool mFLOYD(char option); 
-	bool mCentrality();
-	void printErrorCode(int n); 
+	bool SAVE(const char* filename);
+	Graph* getGraph();
+	bool PRINT(ostream* out);	
+	// Queries that may run side by side take workers, nullptr inside a batch
+	bool mBFS(char option, int vertex, ostream* out, ThreadPool* workers);	
+	bool mBFSLEVEL(char option, int vertex, ostream* out, ThreadPool* workers);
+	bool mDFS(char option, int vertex, ostream* out);	
+	bool mDIJKSTRA(char option, int vertex, ostream* out);	
+	bool mDIJKSTRA_BATCH(char option, const vector<int>& sources, ostream* out);
+	bool mKRUSKAL(ostream* out);	
+	bool mBELLMANFORD(char option, int s_vertex, int e_vertex, ostream* out, ThreadPool* workers);	
+	bool mQUERY(char option, int s_vertex, int e_vertex, ostream* out);
+	bool mFLOYD(char option, ostream* out); 
+	bool mCentrality(ostream* out);
+	bool mINSERT_EDGE(int from, int to, int weight);
+	bool mDELETE_EDGE(int from, int to);
+	bool mUPDATE_WEIGHT(int from, int to, int weight);
+	void applyEdge(int from, int to, bool present, int weight);
+	bool SET(const string& key, const string& value);
+	bool cachedRun(const string& key, ostream* out, const function<bool(ostream*)>& compute);
+	bool findTree(const string& key, bool* ok, vector<int>* dist, vector<int>* prev);
+	void storeTree(const string& key, bool ok, const vector<int>& dist, const vector<int>& prev);
+	bool commandDone();
+	void writeBlock(BoundedQueue<LogBlock>* blocks, string text, bool flush);
+	void printErrorCode(int n, ostream* out); 
 };
 
 #endif
@@ -5,44 +5,27 @@
 
 MatrixGraph::MatrixGraph(bool type, int size) : Graph(type, size)
 {
-	// Allocate 2D matrix for adjacency matrix
-	m_Mat = new int*[size];
-	for (int i = 0; i < size; i++) {
-		m_Mat[i] = new int[size];
-		// Initialize all edges to 0 (no edge)
-		for (int j = 0; j < size; j++) {
-			m_Mat[i][j] = 0;
-		}
-	}
+	// Allocate one contiguous block for the matrix, all edges 0 (no edge)
+	m_Mat = new int[(size_t)size * size]();
 }
 
 MatrixGraph::~MatrixGraph()
 {
-	// Deallocate 2D matrix
-	if (m_Mat) {
-		for (int i = 0; i < m_Size; i++) {
-			delete[] m_Mat[i];
-		}
+	// Deallocate matrix
+	if (m_Mat)
 		delete[] m_Mat;
-	}
 }
 
 void MatrixGraph::getAdjacentEdges(int vertex, map<int, int>* m)
 {	
 	// Get adjacent edges for undirected graph
-	m->clear();
-	
-	// Check outgoing edges from vertex
-	for (int i = 0; i < m_Size; i++) {
-		if (m_Mat[vertex][i] != 0) {
-			(*m)[i] = m_Mat[vertex][i];
-		}
-	}
+	getAdjacentEdgesDirect(vertex, m);
 	
 	// For undirected graph, also check incoming edges
 	for (int i = 0; i < m_Size; i++) {
-		if (i != vertex && m_Mat[i][vertex] != 0) {
-			(*m)[i] = m_Mat[i][vertex];
+		int weight = m_Mat[(size_t)i * m_Size + vertex];
+		if (i != vertex && weight != 0) {
+			(*m)[i] = weight;
 		}
 	}
 }
@@ -53,9 +36,10 @@ void MatrixGraph::getAdjacentEdgesDirect(int vertex, map<int, int>* m)
 	m->clear();
 	
 	// Only check outgoing edges from vertex
+	const int* row = m_Mat + (size_t)vertex * m_Size;
 	for (int i = 0; i < m_Size; i++) {
-		if (m_Mat[vertex][i] != 0) {
-			(*m)[i] = m_Mat[vertex][i];
+		if (row[i] != 0) {
+			(*m)[i] = row[i];
 		}
 	}
 }
@@ -63,10 +47,20 @@ void MatrixGraph::getAdjacentEdgesDirect(int vertex, map<int, int>* m)
 void MatrixGraph::insertEdge(int from, int to, int weight)	
 {
 	// Insert edge from 'from' to 'to' with given weight
-	m_Mat[from][to] = weight;
+	m_Mat[(size_t)from * m_Size + to] = weight;
+}
+
+bool MatrixGraph::deleteEdge(int from, int to)
+{
+	// Weight 0 is "no edge"
+	int* cell = m_Mat + (size_t)from * m_Size + to;
+	if (*cell == 0)
+		return false;
+	*cell = 0;
+	return true;
 }
 
-bool MatrixGraph::printGraph(ofstream *fout)	
+bool MatrixGraph::printGraph(ostream *fout)	
 {
 	// Check if graph exists
 	if (m_Size <= 0)
@@ -77,18 +71,67 @@ bool MatrixGraph::printGraph(ofstream *fout)
 	for (int i = 0; i < m_Size; i++) {
 		*fout << "[" << i << "] ";
 	}
-	*fout << endl;
+	*fout << '\n';
 	
 	// Print matrix with row headers
 	for (int i = 0; i < m_Size; i++) {
 		*fout << "[" << i << "] ";
+		const int* row = m_Mat + (size_t)i * m_Size;
 		for (int j = 0; j < m_Size; j++) {
-			*fout << m_Mat[i][j];
+			*fout << row[j];
 			if (j < m_Size - 1)
 				*fout << " ";
 		}
-		*fout << endl;
+		*fout << '\n';
 	}
 	
 	return true;
+}
+
+EdgeSpan MatrixGraph::getNeighbors(int vertex, bool direct)
+{
+	// One pass over the row (and for undirected, the column) straight
+	// into the scratch arrays, without building a map
+	const int* row = m_Mat + (size_t)vertex * m_Size;
+	m_SpanTo.clear();
+	m_SpanWeight.clear();
+	for (int i = 0; i < m_Size; i++) {
+		// An incoming edge overrides the outgoing one, as in getAdjacentEdges
+		int in = (direct || i == vertex) ? 0 : m_Mat[(size_t)i * m_Size + vertex];
+		int weight = (in != 0) ? in : row[i];
+		if (weight != 0) {
+			m_SpanTo.push_back(i);
+			m_SpanWeight.push_back(weight);
+		}
+	}
+	
+	EdgeSpan span;
+	span.to = m_SpanTo.data();
+	span.weight = m_SpanWeight.data();
+	span.count = (int)m_SpanTo.size();
+	return span;
+}
+
+EdgeSpan MatrixGraph::getReverseNeighbors(int vertex, bool direct)
+{
+	// Every i that has vertex in its neighbor range, with the weight i sees:
+	// the column, and for undirected the row as well
+	const int* row = m_Mat + (size_t)vertex * m_Size;
+	m_SpanTo.clear();
+	m_SpanWeight.clear();
+	for (int i = 0; i < m_Size; i++) {
+		// i sees vertex through its incoming edge from vertex when there is one
+		int out = (direct || i == vertex) ? 0 : row[i];
+		int weight = (out != 0) ? out : m_Mat[(size_t)i * m_Size + vertex];
+		if (weight != 0) {
+			m_SpanTo.push_back(i);
+			m_SpanWeight.push_back(weight);
+		}
+	}
+	
+	EdgeSpan span;
+	span.to = m_SpanTo.data();
+	span.weight = m_SpanWeight.data();
+	span.count = (int)m_SpanTo.size();
+	return span;
 }
\ No newline at end of file
@@ -5,7 +5,7 @@
 
 class MatrixGraph : public Graph{	
 private:
-	int** m_Mat;
+	int* m_Mat;		// Row-major weights, m_Mat[from * m_Size + to]
 
 public:
 	MatrixGraph(bool type, int size);
@@ -14,7 +14,10 @@ public:
 	void getAdjacentEdges(int vertex, map<int, int>* m);	
 	void getAdjacentEdgesDirect(int vertex, map<int, int>* m);
 	void insertEdge(int from, int to, int weight);	
-	bool printGraph(ofstream *fout);
+	bool deleteEdge(int from, int to);
+	bool printGraph(ostream *fout);
+	EdgeSpan getNeighbors(int vertex, bool direct);
+	EdgeSpan getReverseNeighbors(int vertex, bool direct);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "Metrics.h"
+#include "ScratchArena.h"
+#include <atomic>
+#include <algorithm>
+#include <ctime>
+#include <sys/resource.h>
+
+static atomic<long long> workVertices(0), workEdges(0), workPushes(0), workRelaxations(0);
+static thread_local WorkCount threadWork;	// Counts of the command this thread measures
+static thread_local bool measuring = false;
+static atomic<bool> traceOn(false);
+
+void setTrace(bool on)
+{
+	traceOn.store(on, memory_order_relaxed);
+}
+
+bool tracing()
+{
+	return traceOn.load(memory_order_relaxed);
+}
+
+void countWork(long long vertices, long long edges, long long pushes, long long relaxations)
+{
+	if (measuring) {
+		threadWork.vertices += vertices;
+		threadWork.edges += edges;
+		threadWork.pushes += pushes;
+		threadWork.relaxations += relaxations;
+		return;
+	}
+	workVertices.fetch_add(vertices, memory_order_relaxed);
+	workEdges.fetch_add(edges, memory_order_relaxed);
+	workPushes.fetch_add(pushes, memory_order_relaxed);
+	workRelaxations.fetch_add(relaxations, memory_order_relaxed);
+}
+
+// Process totals since the last call; starts them again from 0
+static WorkCount takeWork()
+{
+	WorkCount work;
+	work.vertices = workVertices.exchange(0, memory_order_relaxed);
+	work.edges = workEdges.exchange(0, memory_order_relaxed);
+	work.pushes = workPushes.exchange(0, memory_order_relaxed);
+	work.relaxations = workRelaxations.exchange(0, memory_order_relaxed);
+	return work;
+}
+
+// CPU time of the whole process, or of the calling thread, in milliseconds
+static double cpuMs(bool process)
+{
+	timespec ts;
+	clock_gettime(process ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Peak resident set so far; Linux reports it in KB
+static long peakRssKb()
+{
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+// Nearest-rank percentile of sorted values
+static double percentile(const vector<double>& sorted, int p)
+{
+	size_t rank = (sorted.size() * p + 99) / 100;
+	return sorted[max<size_t>(rank, 1) - 1];
+}
+
+CommandClock CommandMetrics::start(bool alone)
+{
+	if (alone)
+		takeWork();	// Drop anything counted outside a command
+	WorkCount zero = {0, 0, 0, 0};
+	threadWork = zero;
+	measuring = true;
+
+	CommandClock clock;
+	clock.alone = alone;
+	clock.wall = chrono::steady_clock::now();
+	clock.cpu = cpuMs(alone);
+	clock.rss = peakRssKb();
+	return clock;
+}
+
+CommandSample CommandMetrics::stop(const CommandClock& clock)
+{
+	// Peak growth is process-wide, so commands running side by side may
+	// each see some of the others'
+	CommandSample sample;
+	sample.wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - clock.wall).count();
+	sample.cpuMs = cpuMs(clock.alone) - clock.cpu;
+	sample.rssKb = peakRssKb() - clock.rss;
+	sample.work = threadWork;
+	measuring = false;
+	if (clock.alone) {
+		WorkCount shared = takeWork();
+		sample.work.vertices += shared.vertices;
+		sample.work.edges += shared.edges;
+		sample.work.pushes += shared.pushes;
+		sample.work.relaxations += shared.relaxations;
+	}
+	return sample;
+}
+
+void CommandMetrics::record(const string& command, const string& line, const CommandSample& sample)
+{
+	map<string, CommandTotals>::iterator it = m_Totals.find(command);
+	if (it == m_Totals.end()) {
+		CommandTotals totals = {0, 0, {0, 0, 0, 0}, vector<CommandSample>()};
+		it = m_Totals.insert(make_pair(command, totals)).first;
+	}
+	CommandTotals& totals = it->second;
+	totals.runs++;
+	totals.rssKb += sample.rssKb;
+	totals.work.vertices += sample.work.vertices;
+	totals.work.edges += sample.work.edges;
+	totals.work.pushes += sample.work.pushes;
+	totals.work.relaxations += sample.work.relaxations;
+
+	// Reservoir sampling: run n replaces a kept one with chance RESERVOIR/n,
+	// which leaves every run so far equally likely to be kept
+	if (totals.reservoir.size() < RESERVOIR) {
+		totals.reservoir.push_back(sample);
+	} else {
+		unsigned long long pick = m_Random() % (unsigned long long)totals.runs;
+		if (pick < RESERVOIR)
+			totals.reservoir[pick] = sample;
+	}
+
+	if (m_Trailer.is_open()) {
+		m_Trailer << line << " | wall " << sample.wallMs << " ms | cpu " << sample.cpuMs
+			<< " ms | rss +" << sample.rssKb << " KB | vertices " << sample.work.vertices
+			<< " | edges " << sample.work.edges << " | pushes " << sample.work.pushes
+			<< " | relaxations " << sample.work.relaxations << '\n';
+	}
+}
+
+bool CommandMetrics::setTrailer(const string& filename)
+{
+	if (m_Trailer.is_open())
+		m_Trailer.close();
+	if (filename == "OFF")
+		return true;
+	m_Trailer.open(filename.c_str(), ios::out | ios::trunc);
+	return m_Trailer.is_open();
+}
+
+void CommandMetrics::print(ostream* fout, const CacheStats& cache)
+{
+	// One line per command name: run count, wall and CPU percentiles over
+	// the kept runs, then peak growth and work summed over all of them
+	*fout << "========STATS========" << '\n';
+	for (map<string, CommandTotals>::iterator it = m_Totals.begin(); it != m_Totals.end(); it++) {
+		const CommandTotals& totals = it->second;
+		vector<double> wall, cpu;
+		for (size_t i = 0; i < totals.reservoir.size(); i++) {
+			wall.push_back(totals.reservoir[i].wallMs);
+			cpu.push_back(totals.reservoir[i].cpuMs);
+		}
+		sort(wall.begin(), wall.end());
+		sort(cpu.begin(), cpu.end());
+		const WorkCount& work = totals.work;
+
+		*fout << it->first << ": " << totals.runs << " runs"
+			<< " | wall p50 " << percentile(wall, 50) << " ms p99 " << percentile(wall, 99) << " ms"
+			<< " | cpu p50 " << percentile(cpu, 50) << " ms p99 " << percentile(cpu, 99) << " ms"
+			<< " | rss +" << totals.rssKb << " KB | vertices " << work.vertices << " | edges " << work.edges
+			<< " | pushes " << work.pushes << " | relaxations " << work.relaxations << '\n';
+	}
+	
+	// Result cache hits, misses and what it holds now
+	*fout << "CACHE: " << cache.hits << " hits | " << cache.misses << " misses | "
+		<< cache.evictions << " evictions | " << cache.entries << " entries | "
+		<< cache.bytes << " bytes" << '\n';
+	
+	// Scratch space: the most each thread had in use at once, and what the
+	// arenas still hold for the next command
+	ScratchStats arena = scratchStats();
+	*fout << "ARENA: " << arena.threads << " threads | high-water " << arena.highWater / 1024
+		<< " KB (largest thread " << arena.largest / 1024 << " KB) | reserved " << arena.reserved / 1024
+		<< " KB | " << arena.grows << " block allocations" << '\n';
+	*fout << "====================" << '\n' << '\n';
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include "ResultCache.h"
+
+using namespace std;
+
+// Work the algorithms report: vertices and edges they touched, heap
+// entries pushed and distances lowered. Runs add their totals once at the
+// end, from any thread. A thread measuring a command keeps its own counts;
+// the rest go to process totals that a command running alone also takes.
+struct WorkCount{
+	long long vertices;
+	long long edges;
+	long long pushes;
+	long long relaxations;
+};
+
+void countWork(long long vertices, long long edges, long long pushes, long long relaxations);
+
+// Per-command diagnostics on stderr (SET TRACE ON). Off by default, so
+// commands on the hot path never pay for an unbuffered write.
+void setTrace(bool on);
+bool tracing();
+
+// Cost of one command
+struct CommandSample{
+	double wallMs;
+	double cpuMs;		// Every thread of the process, or only its own if not alone
+	long rssKb;		// Growth of the peak resident set
+	WorkCount work;
+};
+
+// Start of one command's measurement
+struct CommandClock{
+	chrono::steady_clock::time_point wall;
+	double cpu;
+	long rss;
+	bool alone;	// Nothing else runs, so pool workers work for this command
+};
+
+// Everything kept for one command name. Runs, peak growth and work are
+// exact sums; the times are a uniform sample of at most RESERVOIR runs,
+// so a long session keeps a fixed size per command.
+struct CommandTotals{
+	long long runs;
+	long long rssKb;
+	WorkCount work;
+	vector<CommandSample> reservoir;
+};
+
+// Totals of every command the Manager ran, grouped by command name, and
+// an optional trailer file that gets one line per command. start and stop
+// measure on the calling thread, so commands running side by side can be
+// measured at once; record adds the samples in command order.
+class CommandMetrics{
+private:
+	static const size_t RESERVOIR = 1024;
+	map<string, CommandTotals> m_Totals;
+	minstd_rand m_Random;	// Fixed seed, so the kept runs repeat
+	ofstream m_Trailer;
+
+public:
+	CommandClock start(bool alone);
+	CommandSample stop(const CommandClock& clock);
+	void record(const string& command, const string& line, const CommandSample& sample);
+	bool setTrailer(const string& filename);	// "OFF" closes it
+	void print(ostream* fout, const CacheStats& cache);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// One line of the command file, split off its command word by the reader
+struct CommandLine{
+	string line;
+	string command;
+};
+
+// Output of one command, in the order the commands were read
+struct LogBlock{
+	string text;
+	bool flush;	// Flush the log after writing it
+};
+
+// Queue between two pipeline stages. push waits while the queue is full,
+// so a fast stage cannot run arbitrarily far ahead of the next one.
+// After close, push refuses new items and pop drains what is left. The
+// consumer calls done once it has finished with a popped item, and drain
+// waits for that on every item pushed so far.
+template <typename T>
+class BoundedQueue{
+private:
+	deque<T> m_Items;
+	size_t m_Limit;
+	size_t m_Pending;	// Pushed but not done yet
+	bool m_Closed;
+	mutex m_Lock;
+	condition_variable m_NotEmpty;
+	condition_variable m_NotFull;
+	condition_variable m_Drained;
+
+public:
+	BoundedQueue(size_t limit)
+	{
+		m_Limit = limit;
+		m_Pending = 0;
+		m_Closed = false;
+	}
+
+	// False when the queue was closed before the item got in
+	bool push(T item)
+	{
+		unique_lock<mutex> lock(m_Lock);
+		while (!m_Closed && m_Items.size() >= m_Limit)
+			m_NotFull.wait(lock);
+		if (m_Closed)
+			return false;
+		m_Items.push_back(move(item));
+		m_Pending++;
+		m_NotEmpty.notify_one();
+		return true;
+	}
+
+	// False once the queue is closed and empty
+	bool pop(T* item)
+	{
+		unique_lock<mutex> lock(m_Lock);
+		while (!m_Closed && m_Items.empty())
+			m_NotEmpty.wait(lock);
+		if (m_Items.empty())
+			return false;
+		*item = move(m_Items.front());
+		m_Items.pop_front();
+		m_NotFull.notify_one();
+		return true;
+	}
+
+	// The consumer is finished with one popped item
+	void done()
+	{
+		lock_guard<mutex> lock(m_Lock);
+		if (--m_Pending == 0)
+			m_Drained.notify_all();
+	}
+
+	// Wait until every item pushed so far is done
+	void drain()
+	{
+		unique_lock<mutex> lock(m_Lock);
+		while (m_Pending > 0)
+			m_Drained.wait(lock);
+	}
+
+	void close()
+	{
+		lock_guard<mutex> lock(m_Lock);
+		m_Closed = true;
+		m_NotEmpty.notify_all();
+		m_NotFull.notify_all();
+	}
+};
+
+#endif
\ No newline at end of file
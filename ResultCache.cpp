@@ -0,0 +1,142 @@
+#include "ResultCache.h"
+
+ResultCache::ResultCache()
+{
+	m_Limit = 64 << 20;	// 64 MB by default
+	m_Stats.hits = 0;
+	m_Stats.misses = 0;
+	m_Stats.evictions = 0;
+	m_Stats.entries = 0;
+	m_Stats.bytes = 0;
+}
+
+void ResultCache::clear()
+{
+	m_Entries.clear();
+	m_Index.clear();
+	m_Stats.entries = 0;
+	m_Stats.bytes = 0;
+}
+
+void ResultCache::setLimit(size_t bytes)
+{
+	m_Limit = bytes;
+	trim();
+}
+
+void ResultCache::trim()
+{
+	// Drop the oldest entries until the limit holds
+	while (m_Stats.bytes > m_Limit) {
+		m_Stats.bytes -= m_Entries.back().bytes;
+		m_Index.erase(m_Entries.back().key);
+		m_Entries.pop_back();
+		m_Stats.entries--;
+		m_Stats.evictions++;
+	}
+}
+
+bool ResultCache::enabled()
+{
+	return m_Limit > 0;
+}
+
+ResultCache::Entry* ResultCache::find(const string& key)
+{
+	auto it = m_Index.find(key);
+	if (it == m_Index.end()) {
+		m_Stats.misses++;
+		return nullptr;
+	}
+	
+	// Move the entry to the front of the LRU list
+	m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+	m_Stats.hits++;
+	return &m_Entries.front();
+}
+
+void ResultCache::store(Entry& entry)
+{
+	entry.bytes = entry.key.size() + entry.text.size()
+		+ (entry.dist.size() + entry.prev.size()) * sizeof(int) + sizeof(Entry);
+	
+	// An entry bigger than the whole cache is not kept
+	if (entry.bytes > m_Limit)
+		return;
+	
+	// Replace an older entry under the same key
+	auto it = m_Index.find(entry.key);
+	if (it != m_Index.end()) {
+		m_Stats.bytes -= it->second->bytes;
+		m_Entries.erase(it->second);
+		m_Index.erase(it);
+		m_Stats.entries--;
+	}
+	
+	m_Stats.entries++;
+	m_Stats.bytes += entry.bytes;
+	m_Entries.push_front(move(entry));
+	m_Index[m_Entries.front().key] = m_Entries.begin();
+	trim();
+}
+
+bool ResultCache::findText(const string& key, bool* ok, const string** text)
+{
+	Entry* entry = find(key);
+	if (!entry)
+		return false;
+	*ok = entry->ok;
+	*text = &entry->text;
+	return true;
+}
+
+void ResultCache::storeText(const string& key, bool ok, const string& text)
+{
+	Entry entry;
+	entry.key = key;
+	entry.ok = ok;
+	entry.text = text;
+	store(entry);
+}
+
+bool ResultCache::findTree(const string& key, bool* ok, const vector<int>** dist, const vector<int>** prev)
+{
+	Entry* entry = find(key);
+	if (!entry)
+		return false;
+	*ok = entry->ok;
+	*dist = &entry->dist;
+	*prev = &entry->prev;
+	return true;
+}
+
+void ResultCache::storeTree(const string& key, bool ok, const vector<int>& dist, const vector<int>& prev)
+{
+	Entry entry;
+	entry.key = key;
+	entry.ok = ok;
+	entry.dist = dist;
+	entry.prev = prev;
+	store(entry);
+}
+
+void ResultCache::patch(const function<bool(const string& key, bool* ok, vector<int>* dist, vector<int>* prev)>& update)
+{
+	// Hand every entry to update; the ones it cannot bring up to date go
+	list<Entry>::iterator it = m_Entries.begin();
+	while (it != m_Entries.end()) {
+		if (update(it->key, &it->ok, &it->dist, &it->prev)) {
+			it++;
+			continue;
+		}
+		m_Stats.bytes -= it->bytes;
+		m_Index.erase(it->key);
+		it = m_Entries.erase(it);
+		m_Stats.entries--;
+	}
+}
+
+CacheStats ResultCache::getStats()
+{
+	return m_Stats;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef _RESULTCACHE_H_
+#define _RESULTCACHE_H_
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <functional>
+
+using namespace std;
+
+// Hit and miss counts since the cache was created
+struct CacheStats{
+	long long hits;
+	long long misses;
+	long long evictions;	// Entries dropped to stay under the limit
+	int entries;
+	size_t bytes;
+};
+
+// Results of the commands run against the loaded graph, keyed by the
+// normalized command line ("BFS O 3"). An entry holds either the printed
+// block or a single-source tree (distance and parent arrays; FLOYD keeps
+// its matrix as a tree without parents), plus whether the command
+// succeeded. The least recently used entries are dropped once the total
+// size passes the limit. LOAD must clear it; an edge update patches the
+// trees it can and drops the rest.
+class ResultCache{
+private:
+	struct Entry{
+		string key;
+		bool ok;		// The command succeeded
+		string text;		// Printed block
+		vector<int> dist;	// Single-source tree
+		vector<int> prev;
+		size_t bytes;
+	};
+
+	list<Entry> m_Entries;	// Most recently used first
+	unordered_map<string, list<Entry>::iterator> m_Index;
+	size_t m_Limit;
+	CacheStats m_Stats;
+
+	Entry* find(const string& key);
+	void store(Entry& entry);
+	void trim();
+
+public:
+	ResultCache();
+
+	void clear();
+	void setLimit(size_t bytes);
+	bool enabled();
+	bool findText(const string& key, bool* ok, const string** text);
+	void storeText(const string& key, bool ok, const string& text);
+	bool findTree(const string& key, bool* ok, const vector<int>** dist, const vector<int>** prev);
+	void storeTree(const string& key, bool ok, const vector<int>& dist, const vector<int>& prev);
+	void patch(const function<bool(const string& key, bool* ok, vector<int>* dist, vector<int>* prev)>& update);
+	CacheStats getStats();
+};
+
+#endif
\ No newline at end of file
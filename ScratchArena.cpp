@@ -0,0 +1,155 @@
+#include "ScratchArena.h"
+#include <mutex>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+// Smallest block, and the most an empty arena holds on to between commands
+static const size_t MIN_BLOCK = 64 << 10;
+static const size_t KEEP_BYTES = 64 << 20;
+static const size_t ALIGN = 16;
+
+// Every live arena, plus what exited threads' arenas reached
+static mutex registryLock;
+static vector<ScratchArena*> registry;
+static ScratchStats retired = {0, 0, 0, 0, 0};
+
+ScratchArena::ScratchArena() : m_HighWater(0), m_Reserved(0), m_Grows(0)
+{
+	m_Block = 0;
+	m_Used = 0;
+	m_InUse = 0;
+	lock_guard<mutex> lock(registryLock);
+	registry.push_back(this);
+}
+
+ScratchArena::~ScratchArena()
+{
+	{
+		lock_guard<mutex> lock(registryLock);
+		registry.erase(find(registry.begin(), registry.end(), this));
+		retired.threads++;
+		retired.highWater += getHighWater();
+		retired.largest = max(retired.largest, getHighWater());
+		retired.grows += getGrows();
+	}
+	release();
+}
+
+void ScratchArena::release()
+{
+	for (size_t b = 0; b < m_Blocks.size(); b++) {
+		free(m_Blocks[b]);
+	}
+	m_Blocks.clear();
+	m_Sizes.clear();
+	m_Block = 0;
+	m_Used = 0;
+	m_Reserved.store(0, memory_order_relaxed);
+}
+
+void* ScratchArena::grow(size_t bytes)
+{
+	// Move on to the next kept block that fits, or add one after the last
+	size_t next = m_Blocks.empty() ? 0 : m_Block + 1;
+	while (next < m_Blocks.size() && m_Sizes[next] < bytes) next++;
+	if (next == m_Blocks.size()) {
+		size_t size = max(bytes, m_Blocks.empty() ? MIN_BLOCK : 2 * m_Sizes.back());
+		char* data = (char*)malloc(size);
+		if (!data)
+			throw bad_alloc();
+		m_Blocks.push_back(data);
+		m_Sizes.push_back(size);
+		m_Reserved.fetch_add(size, memory_order_relaxed);
+		m_Grows.fetch_add(1, memory_order_relaxed);
+	}
+	m_Block = next;
+	m_Used = bytes;
+	return m_Blocks[next];
+}
+
+void* ScratchArena::allocate(size_t bytes)
+{
+	bytes = (bytes + ALIGN - 1) & ~(ALIGN - 1);
+	void* data;
+	if (m_Block < m_Blocks.size() && m_Used + bytes <= m_Sizes[m_Block]) {
+		data = m_Blocks[m_Block] + m_Used;
+		m_Used += bytes;
+	} else {
+		data = grow(bytes);
+	}
+	m_InUse += bytes;
+	if (m_InUse > m_HighWater.load(memory_order_relaxed))
+		m_HighWater.store(m_InUse, memory_order_relaxed);
+	return data;
+}
+
+ScratchMark ScratchArena::mark()
+{
+	ScratchMark mark;
+	mark.block = m_Block;
+	mark.used = m_Used;
+	mark.inUse = m_InUse;
+	return mark;
+}
+
+void ScratchArena::rewind(const ScratchMark& mark)
+{
+	m_Block = mark.block;
+	m_Used = mark.used;
+	m_InUse = mark.inUse;
+	if (m_InUse > 0)
+		return;
+
+	// Empty again: fold several blocks into one, and give back whatever is
+	// past the amount worth keeping
+	size_t reserved = getReserved();
+	if (m_Blocks.size() <= 1 && reserved <= KEEP_BYTES)
+		return;
+	release();
+	if (reserved <= KEEP_BYTES) {
+		char* data = (char*)malloc(reserved);
+		if (!data)
+			return;
+		m_Blocks.push_back(data);
+		m_Sizes.push_back(reserved);
+		m_Reserved.store(reserved, memory_order_relaxed);
+		m_Grows.fetch_add(1, memory_order_relaxed);
+	}
+}
+
+size_t ScratchArena::getHighWater()
+{
+	return m_HighWater.load(memory_order_relaxed);
+}
+
+size_t ScratchArena::getReserved()
+{
+	return m_Reserved.load(memory_order_relaxed);
+}
+
+long long ScratchArena::getGrows()
+{
+	return m_Grows.load(memory_order_relaxed);
+}
+
+ScratchArena& threadScratch()
+{
+	static thread_local ScratchArena arena;
+	return arena;
+}
+
+ScratchStats scratchStats()
+{
+	lock_guard<mutex> lock(registryLock);
+	ScratchStats stats = retired;
+	for (size_t i = 0; i < registry.size(); i++) {
+		ScratchArena* arena = registry[i];
+		stats.threads++;
+		stats.highWater += arena->getHighWater();
+		stats.largest = max(stats.largest, arena->getHighWater());
+		stats.reserved += arena->getReserved();
+		stats.grows += arena->getGrows();
+	}
+	return stats;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef _SCRATCHARENA_H_
+#define _SCRATCHARENA_H_
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+using namespace std;
+
+// A position in an arena to rewind to
+struct ScratchMark{
+	size_t block;
+	size_t used;
+	size_t inUse;
+};
+
+// Bump allocator for an algorithm's working arrays. Space is handed out
+// from large blocks and given back all at once by rewinding to a mark.
+// Blocks stay allocated between commands; once the arena is empty again
+// they are folded into a single block as large as all of them, so a
+// steady stream of commands stops calling malloc after the first few.
+// One arena per thread; only its owner allocates from it.
+class ScratchArena{
+private:
+	vector<char*> m_Blocks;
+	vector<size_t> m_Sizes;
+	size_t m_Block;		// Block being filled
+	size_t m_Used;		// Bytes of it handed out
+	size_t m_InUse;		// Bytes handed out in all blocks
+	atomic<size_t> m_HighWater;	// Most bytes in use at once
+	atomic<size_t> m_Reserved;	// Bytes of all blocks
+	atomic<long long> m_Grows;	// Blocks allocated
+
+	void* grow(size_t bytes);
+	void release();
+
+public:
+	ScratchArena();
+	~ScratchArena();
+
+	void* allocate(size_t bytes);
+	ScratchMark mark();
+	void rewind(const ScratchMark& mark);
+	size_t getHighWater();
+	size_t getReserved();
+	long long getGrows();
+};
+
+// The calling thread's arena
+ScratchArena& threadScratch();
+
+// High-water marks over every thread's arena, live or exited
+struct ScratchStats{
+	int threads;
+	size_t highWater;	// Sum of the per-thread marks
+	size_t largest;		// Largest per-thread mark
+	size_t reserved;	// Held by live threads now
+	long long grows;
+};
+
+ScratchStats scratchStats();
+
+// Scratch space taken from the thread's arena until the scope closes.
+// Scopes nest; arrays are uninitialized unless a fill value is given.
+class ScratchScope{
+private:
+	ScratchArena& m_Arena;
+	ScratchMark m_Mark;
+
+public:
+	ScratchScope() : m_Arena(threadScratch()), m_Mark(m_Arena.mark()) {}
+	~ScratchScope() { m_Arena.rewind(m_Mark); }
+
+	template <typename T>
+	T* take(size_t count)
+	{
+		static_assert(is_trivially_destructible<T>::value, "scratch arrays are never destroyed");
+		return (T*)m_Arena.allocate(count * sizeof(T));
+	}
+
+	template <typename T>
+	T* take(size_t count, T value)
+	{
+		T* data = take<T>(count);
+		for (size_t i = 0; i < count; i++) data[i] = value;
+		return data;
+	}
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include "SparsePaths.h"
+#include "IndexedHeap.h"
+#include "VisitMarks.h"
+#include "Metrics.h"
+#include <algorithm>
+
+// Neighbors along the chosen direction of the chosen view
+static EdgeSpan edgesOf(Graph* graph, int vertex, bool direct, bool reverse)
+{
+	return reverse ? graph->getReverseNeighbors(vertex, direct) : graph->getNeighbors(vertex, direct);
+}
+
+WeightProfile profileWeights(Graph* graph, bool direct)
+{
+	WeightProfile profile;
+	profile.edges = 0;
+	profile.negative = false;
+	profile.unit = true;
+	profile.minWeight = INT_MAX;
+	profile.maxWeight = INT_MIN;
+	
+	// One pass over every edge of the view
+	int size = graph->getSize();
+	for (int i = 0; i < size; i++) {
+		EdgeSpan edges = graph->getNeighbors(i, direct);
+		profile.edges += edges.count;
+		for (int k = 0; k < edges.count; k++) {
+			int w = edges.weight[k];
+			if (w < profile.minWeight) profile.minWeight = w;
+			if (w > profile.maxWeight) profile.maxWeight = w;
+			if (w != 1) profile.unit = false;
+		}
+	}
+	profile.negative = (profile.edges > 0 && profile.minWeight < 0);
+	return profile;
+}
+
+bool preferSparseAllPairs(Graph* graph, const WeightProfile& profile)
+{
+	long long v = graph->getSize();
+	
+	// A dense V x V matrix over 512 MB is not an option at all
+	if (v * v > (1LL << 27))
+		return true;
+	
+	// V single-source runs cost about V * E log V against the V^3 / SIMD-width
+	// of the tiled kernel, so go sparse once E log V is well below V^2
+	long long logV = 1;
+	while ((1LL << logV) < v)
+		logV++;
+	return profile.edges * logV * 8 < v * v;
+}
+
+bool johnsonPotentials(Graph* graph, bool direct, bool reverse, vector<long long>* h)
+{
+	// Bellman-Ford from a virtual source joined to every vertex by a 0 edge,
+	// so every vertex starts at 0; stop as soon as a pass changes nothing
+	int size = graph->getSize();
+	h->assign(size, 0);
+	long long scanned = 0, relaxed = 0;
+	
+	for (int pass = 0; pass <= size; pass++) {
+		bool changed = false;
+		for (int u = 0; u < size; u++) {
+			EdgeSpan edges = edgesOf(graph, u, direct, reverse);
+			scanned += edges.count;
+			for (int k = 0; k < edges.count; k++) {
+				long long cand = (*h)[u] + edges.weight[k];
+				if (cand < (*h)[edges.to[k]]) {
+					(*h)[edges.to[k]] = cand;
+					changed = true;
+					relaxed++;
+				}
+			}
+		}
+		if (!changed) {
+			countWork((long long)(pass + 1) * size, scanned, 0, relaxed);
+			return true;
+		}
+	}
+	
+	// Still relaxing after V + 1 passes (V vertices plus the virtual source)
+	countWork((long long)(size + 1) * size, scanned, 0, relaxed);
+	return false;
+}
+
+void shortestFrom(Graph* graph, bool direct, bool reverse, int source,
+	const vector<long long>* potential, bool unit, SsspWorkspace* ws)
+{
+	int size = graph->getSize();
+	vector<long long>& dist = ws->dist;
+	dist.assign(size, SSSP_INF);
+	dist[source] = 0;
+	
+	// Unit weights: plain BFS levels are the distances
+	if (unit) {
+		vector<int>& queue = ws->queue;
+		queue.clear();
+		queue.push_back(source);
+		long long scanned = 0;
+		for (size_t head = 0; head < queue.size(); head++) {
+			int curr = queue[head];
+			EdgeSpan edges = edgesOf(graph, curr, direct, reverse);
+			scanned += edges.count;
+			for (int k = 0; k < edges.count; k++) {
+				int next = edges.to[k];
+				if (dist[next] == SSSP_INF) {
+					dist[next] = dist[curr] + 1;
+					queue.push_back(next);
+				}
+			}
+		}
+		countWork(queue.size(), scanned, queue.size(), queue.size() - 1);
+		return;
+	}
+	
+	// Otherwise Dijkstra; with potentials every reduced weight
+	// w + h(u) - h(v) is non-negative
+	vector<pair<long long, int>>& heap = ws->heap;
+	greater<pair<long long, int>> later;
+	heap.clear();
+	heap.push_back(make_pair(0LL, source));
+	long long settled = 0, scanned = 0, pushes = 1;
+	while (!heap.empty()) {
+		pop_heap(heap.begin(), heap.end(), later);
+		long long d = heap.back().first;
+		int curr = heap.back().second;
+		heap.pop_back();
+		if (d > dist[curr]) continue;
+		
+		EdgeSpan edges = edgesOf(graph, curr, direct, reverse);
+		settled++;
+		scanned += edges.count;
+		for (int k = 0; k < edges.count; k++) {
+			int next = edges.to[k];
+			long long w = edges.weight[k];
+			if (potential)
+				w += (*potential)[curr] - (*potential)[next];
+			if (d + w < dist[next]) {
+				dist[next] = d + w;
+				heap.push_back(make_pair(dist[next], next));
+				push_heap(heap.begin(), heap.end(), later);
+				pushes++;
+			}
+		}
+	}
+	countWork(settled, scanned, pushes, pushes - 1);
+	
+	// Undo the reweighting: d(s, v) = d'(s, v) - h(s) + h(v)
+	if (potential) {
+		for (int v = 0; v < size; v++) {
+			if (dist[v] != SSSP_INF)
+				dist[v] += (*potential)[v] - (*potential)[source];
+		}
+	}
+}
+
+SsspWorkspace* threadWorkspace()
+{
+	// One workspace per thread, kept for the thread's lifetime
+	static thread_local SsspWorkspace ws;
+	return &ws;
+}
+
+void buildQueryIndex(Graph* graph, int landmarks, QueryIndex* index)
+{
+	int size = graph->getSize();
+	WeightProfile profile = profileWeights(graph, true);
+	index->negative = profile.negative;
+	index->landmarks = 0;
+	for (int view = 0; view < 2; view++) {
+		index->from[view].clear();
+		index->to[view].clear();
+	}
+	
+	// Landmark bounds only hold for non-negative weights
+	if (landmarks <= 0 || size == 0 || profile.negative)
+		return;
+	if (landmarks > size)
+		landmarks = size;
+	
+	// Farthest-first choice by hop count on the undirected view: each new
+	// landmark is the vertex farthest from all earlier ones (the first is
+	// the one farthest from vertex 0). A vertex none of them reaches counts
+	// as farthest, so every component gets a landmark.
+	SsspWorkspace ws;
+	vector<long long> nearest(size, SSSP_INF);
+	vector<char> isLandmark(size, 0);
+	vector<int> chosen;
+	shortestFrom(graph, false, false, 0, nullptr, true, &ws);
+	vector<long long> hops = ws.dist;
+	while ((int)chosen.size() < landmarks) {
+		int next = -1;
+		for (int v = 0; v < size; v++) {
+			if (!isLandmark[v] && (next == -1 || hops[v] > hops[next]))
+				next = v;
+		}
+		chosen.push_back(next);
+		isLandmark[next] = 1;
+		
+		shortestFrom(graph, false, false, next, nullptr, true, &ws);
+		for (int v = 0; v < size; v++) {
+			nearest[v] = min(nearest[v], ws.dist[v]);
+		}
+		hops = nearest;
+	}
+	
+	// Distances from and to every landmark in both views
+	index->landmarks = (int)chosen.size();
+	for (int view = 0; view < 2; view++) {
+		index->from[view].resize((size_t)index->landmarks * size);
+		index->to[view].resize((size_t)index->landmarks * size);
+		for (int l = 0; l < index->landmarks; l++) {
+			shortestFrom(graph, view == 1, false, chosen[l], nullptr, profile.unit, &ws);
+			copy(ws.dist.begin(), ws.dist.end(), index->from[view].begin() + (size_t)l * size);
+			shortestFrom(graph, view == 1, true, chosen[l], nullptr, profile.unit, &ws);
+			copy(ws.dist.begin(), ws.dist.end(), index->to[view].begin() + (size_t)l * size);
+		}
+	}
+}
+
+
+// Lower bounds from the landmark tables by the triangle inequality:
+// d(v, t) >= d(l, t) - d(l, v) and d(v, t) >= d(v, l) - d(t, l)
+static long long landmarkBound(const QueryIndex* index, int view, int size, int v, int t)
+{
+	long long bound = 0;
+	for (int l = 0; l < index->landmarks; l++) {
+		const long long* from = &index->from[view][(size_t)l * size];
+		const long long* to = &index->to[view][(size_t)l * size];
+		if (from[t] != SSSP_INF && from[v] != SSSP_INF)
+			bound = max(bound, from[t] - from[v]);
+		if (to[v] != SSSP_INF && to[t] != SSSP_INF)
+			bound = max(bound, to[v] - to[t]);
+	}
+	return bound;
+}
+
+long long pointToPoint(Graph* graph, bool direct, int source, int target, const QueryIndex* index,
+	vector<int>* path, QueryStats* stats)
+{
+	int size = graph->getSize();
+	int view = direct ? 1 : 0;
+	stats->settled = 0;
+	stats->relaxed = 0;
+	stats->pushes = 0;
+	stats->lowered = 0;
+	path->clear();
+	
+	// Buffers per thread, reused between queries. A side's distance and
+	// tree link are set together when it first reaches a vertex and read
+	// only where its marks say so, so starting a query clears nothing and
+	// a query costs what its two searches explore.
+	static thread_local IndexedHeap forward, backward;
+	static thread_local VisitMarks reachedF, reachedB;
+	static thread_local vector<long long> distF, distB;
+	static thread_local vector<int> prevF, nextB;
+	forward.reset(size);
+	backward.reset(size);
+	reachedF.reset(size);
+	reachedB.reset(size);
+	if ((int)distF.size() < size) {
+		distF.resize(size);
+		distB.resize(size);
+		prevF.resize(size);
+		nextB.resize(size);
+	}
+	
+	// Twice the averaged ALT potential, lower bound on d(v, t) minus lower
+	// bound on d(s, v). Both searches stay consistent with it, and with no
+	// landmarks it is 0 and this is plain bidirectional Dijkstra.
+	bool alt = (index && index->landmarks > 0);
+	auto potential = [&](int v) -> long long {
+		if (!alt) return 0;
+		return landmarkBound(index, view, size, v, target) - landmarkBound(index, view, size, source, v);
+	};
+	long long pSource = potential(source);
+	long long pTarget = potential(target);
+	
+	reachedF.mark(source);
+	distF[source] = 0;
+	prevF[source] = -1;
+	reachedB.mark(target);
+	distB[target] = 0;
+	nextB[target] = -1;
+	forward.push(source, 0);
+	backward.push(target, 0);
+	long long best = (source == target) ? 0 : SSSP_INF;
+	int meet = source;
+	
+	// Keys are 2d(s, v) + p(v) - p(s) forward and 2d(v, t) - p(v) + p(t)
+	// backward, so a path through v has key sum 2 len + p(t) - p(s). Once
+	// the two smallest keys reach that for the best path, nothing shorter
+	// is left. An exhausted side has settled all it reaches, so also stop.
+	while (!forward.empty() && !backward.empty()) {
+		if (best != SSSP_INF && forward.topKey() + backward.topKey() >= 2 * best + pTarget - pSource)
+			break;
+		
+		bool isForward = forward.topKey() <= backward.topKey();
+		long long key;
+		int curr = isForward ? forward.pop(&key) : backward.pop(&key);
+		stats->settled++;
+		
+		EdgeSpan edges = isForward ? graph->getNeighbors(curr, direct) : graph->getReverseNeighbors(curr, direct);
+		stats->relaxed += edges.count;
+		VisitMarks& reached = isForward ? reachedF : reachedB;
+		VisitMarks& otherReached = isForward ? reachedB : reachedF;
+		vector<long long>& dist = isForward ? distF : distB;
+		vector<long long>& other = isForward ? distB : distF;
+		for (int k = 0; k < edges.count; k++) {
+			int next = edges.to[k];
+			long long cand = dist[curr] + edges.weight[k];
+			if (!reached.visit(next) && cand >= dist[next]) continue;
+			
+			dist[next] = cand;
+			stats->lowered++;
+			if (isForward) {
+				prevF[next] = curr;
+				forward.push(next, 2 * cand + potential(next) - pSource);
+			} else {
+				nextB[next] = curr;
+				backward.push(next, 2 * cand - potential(next) + pTarget);
+			}
+			
+			// Both searches have reached next: a candidate path
+			if (otherReached.test(next) && cand + other[next] < best) {
+				best = cand + other[next];
+				meet = next;
+			}
+		}
+	}
+	stats->pushes = forward.getStats().pushes + backward.getStats().pushes;
+	if (best == SSSP_INF)
+		return SSSP_INF;
+	
+	// Forward tree back to the source, then the backward tree on to the target
+	for (int v = meet; v != -1; v = prevF[v])
+		path->push_back(v);
+	reverse(path->begin(), path->end());
+	for (int v = nextB[meet]; v != -1; v = nextB[v])
+		path->push_back(v);
+	return best;
+}
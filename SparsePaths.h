@@ -0,0 +1,54 @@
+#ifndef _SPARSEPATHS_H_
+#define _SPARSEPATHS_H_
+
+#include "Graph.h"
+#include <climits>
+
+// Distance used for vertices a single-source run did not reach
+const long long SSSP_INF = LLONG_MAX;
+
+// Summary of one adjacency view, gathered in a single scan
+struct WeightProfile{
+	long long edges;	// Entries in the view
+	bool negative;		// Some weight is below zero
+	bool unit;		// Every weight is exactly 1
+	int minWeight;
+	int maxWeight;
+};
+
+// Buffers for one single-source run, sized to V and reused between runs
+struct SsspWorkspace{
+	vector<long long> dist;
+	vector<int> queue;			// BFS queue
+	vector<pair<long long, int>> heap;	// Binary heap {distance, vertex}
+};
+
+// Per-graph data for point-to-point queries, built once at LOAD.
+// For landmark l and vertex v, from[view][l * V + v] = d(l, v) and
+// to[view][l * V + v] = d(v, l); view 1 is directed, 0 undirected.
+struct QueryIndex{
+	bool negative;			// Some weight is below zero; queries refuse
+	int landmarks;			// Landmarks in the tables, 0 = plain search
+	vector<long long> from[2];
+	vector<long long> to[2];
+};
+
+// Work counters of one point-to-point query
+struct QueryStats{
+	long long settled;	// Vertices taken off either heap
+	long long relaxed;	// Edges scanned
+	long long pushes;	// Heap entries added, both sides
+	long long lowered;	// Distances lowered, both sides
+};
+
+WeightProfile profileWeights(Graph* graph, bool direct);
+bool preferSparseAllPairs(Graph* graph, const WeightProfile& profile);
+bool johnsonPotentials(Graph* graph, bool direct, bool reverse, vector<long long>* h);
+void shortestFrom(Graph* graph, bool direct, bool reverse, int source,
+	const vector<long long>* potential, bool unit, SsspWorkspace* ws);
+SsspWorkspace* threadWorkspace();
+void buildQueryIndex(Graph* graph, int landmarks, QueryIndex* index);
+long long pointToPoint(Graph* graph, bool direct, int source, int target, const QueryIndex* index,
+	vector<int>* path, QueryStats* stats);
+
+#endif
\ No newline at end of file
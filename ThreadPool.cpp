@@ -0,0 +1,94 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threads)
+{
+	m_Stop = false;
+	
+	// The caller counts as one thread, so start one worker fewer
+	for (int i = 1; i < threads; i++) {
+		m_Workers.push_back(thread(&ThreadPool::workerLoop, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	// Wake every worker and wait for it to exit
+	{
+		lock_guard<mutex> lock(m_Lock);
+		m_Stop = true;
+	}
+	m_Wake.notify_all();
+	for (size_t i = 0; i < m_Workers.size(); i++) {
+		m_Workers[i].join();
+	}
+}
+
+int ThreadPool::getThreads()
+{
+	return (int)m_Workers.size() + 1;
+}
+
+bool ThreadPool::runOne(unique_lock<mutex>& lock, Job* job)
+{
+	// Claim the next index under the lock; false if none are left
+	if (job->next >= job->count)
+		return false;
+	int index = job->next++;
+	if (job->next == job->count) {
+		// Fully handed out, so take it off the queue
+		for (size_t i = 0; i < m_Jobs.size(); i++) {
+			if (m_Jobs[i] == job) {
+				m_Jobs.erase(m_Jobs.begin() + i);
+				break;
+			}
+		}
+	}
+	
+	// Run the body unlocked, then record completion
+	lock.unlock();
+	(*job->body)(index);
+	lock.lock();
+	
+	job->finished++;
+	if (job->finished == job->count)
+		m_Done.notify_all();
+	return true;
+}
+
+void ThreadPool::workerLoop()
+{
+	unique_lock<mutex> lock(m_Lock);
+	while (true) {
+		// Sleep until there is a job with unclaimed indices, or shutdown
+		m_Wake.wait(lock, [this]{ return m_Stop || !m_Jobs.empty(); });
+		if (m_Jobs.empty())
+			return;
+		runOne(lock, m_Jobs.front());
+	}
+}
+
+void ThreadPool::parallelFor(int count, const function<void(int)>& body)
+{
+	if (count <= 0)
+		return;
+	
+	Job job;
+	job.body = &body;
+	job.count = count;
+	job.next = 0;
+	job.finished = 0;
+	
+	unique_lock<mutex> lock(m_Lock);
+	if (!m_Workers.empty()) {
+		m_Jobs.push_back(&job);
+		m_Wake.notify_all();
+	}
+	
+	// Work on our own job until every index is claimed
+	while (runOne(lock, &job)) {
+	}
+	
+	// Wait for indices still running on workers; after this no worker
+	// holds a pointer to the job
+	m_Done.wait(lock, [&job]{ return job.finished == job.count; });
+}
\ No newline at end of file
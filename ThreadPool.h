@@ -0,0 +1,44 @@
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+// Fixed set of worker threads that run parallel-for loops.
+// The calling thread works on its own loop too, so loops may be started
+// from several threads at once (or from inside a loop) without deadlock.
+class ThreadPool{
+private:
+	// One parallelFor call; lives on the caller's stack
+	struct Job{
+		const function<void(int)>* body;
+		int count;		// Number of indices
+		int next;		// Next index to hand out
+		int finished;		// Indices whose body has returned
+	};
+
+	vector<thread> m_Workers;
+	deque<Job*> m_Jobs;		// Jobs that still have unclaimed indices
+	mutex m_Lock;
+	condition_variable m_Wake;	// Signals workers that a job arrived
+	condition_variable m_Done;	// Signals callers that an index finished
+	bool m_Stop;
+
+	void workerLoop();
+	bool runOne(unique_lock<mutex>& lock, Job* job);
+
+public:
+	ThreadPool(int threads);
+	~ThreadPool();
+
+	int getThreads();
+	void parallelFor(int count, const function<void(int)>& body);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "VisitMarks.h"
+#include <algorithm>
+
+VisitMarks::VisitMarks()
+{
+	// Stamp 0 is never an epoch, so new stamps start out unmarked
+	m_Epoch = 0;
+}
+
+void VisitMarks::reset(int size)
+{
+	// Only ever grows: a smaller graph uses a prefix of the stamps
+	if ((int)m_Stamp.size() < size)
+		m_Stamp.resize(size, 0);
+
+	m_Epoch++;
+	if (m_Epoch == 0) {
+		fill(m_Stamp.begin(), m_Stamp.end(), 0);
+		m_Epoch = 1;
+	}
+}
\ No newline at end of file
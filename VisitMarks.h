@@ -0,0 +1,39 @@
+#ifndef _VISITMARKS_H_
+#define _VISITMARKS_H_
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Per-vertex flags that clear in O(1). A vertex is marked when its stamp
+// equals the current epoch, so reset only moves to the next epoch and a
+// search pays for the vertices it touches rather than for all V. The
+// stamps are zeroed for real only when the epoch counter wraps around.
+// Values kept next to the marks (distances, parents) are valid exactly
+// where a vertex is marked and need no clearing either.
+class VisitMarks{
+private:
+	vector<uint32_t> m_Stamp;
+	uint32_t m_Epoch;
+
+public:
+	VisitMarks();
+
+	void reset(int size);	// Unmark every vertex in 0..size-1
+
+	bool test(int v) const { return m_Stamp[v] == m_Epoch; }
+	void mark(int v) { m_Stamp[v] = m_Epoch; }
+	void unmark(int v) { m_Stamp[v] = 0; }
+
+	// Mark v; true when it was not marked yet
+	bool visit(int v)
+	{
+		if (m_Stamp[v] == m_Epoch)
+			return false;
+		m_Stamp[v] = m_Epoch;
+		return true;
+	}
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+// Thread scaling benchmark for the blocked Floyd-Warshall kernel.
+// Usage: bench_floyd [vertices] [average out-degree]
+// Prints CSV: threads,vertices,block,seconds,speedup
+#include "../FloydKernel.h"
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+
+int main(int argc, char** argv)
+{
+	int n = (argc > 1) ? atoi(argv[1]) : 2000;
+	int degree = (argc > 2) ? atoi(argv[2]) : 8;
+	
+	// Random sparse graph with a fixed seed so runs are comparable
+	mt19937 rng(12345);
+	vector<int> base((size_t)n * n, FLOYD_INF);
+	for (int i = 0; i < n; i++) {
+		base[(size_t)i * n + i] = 0;
+		for (int e = 0; e < degree; e++) {
+			base[(size_t)i * n + rng() % n] = 1 + rng() % 100;
+		}
+	}
+	
+	int counts[] = { 1, 2, 4, 8, 16 };
+	double serial = 0;
+	vector<int> reference;
+	printf("threads,vertices,block,seconds,speedup\n");
+	for (int t = 0; t < 5; t++) {
+		ThreadPool pool(counts[t]);
+		int block = floydBlockSize(n, counts[t]);
+		vector<int> dist = base;
+		
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		floydBlocked(dist.data(), n, block, &pool);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		
+		// Every thread count has to produce the same matrix
+		if (t == 0) {
+			serial = seconds;
+			reference = dist;
+		} else if (dist != reference) {
+			fprintf(stderr, "result mismatch at %d threads\n", counts[t]);
+			return 1;
+		}
+		printf("%d,%d,%d,%.4f,%.2f\n", counts[t], n, block, seconds, serial / seconds);
+	}
+	return 0;
+}
@@ -0,0 +1,199 @@
+// Times every GraphMethod entry point on ListGraph, MatrixGraph and CsrGraph.
+// Usage: bench_methods [--json] [--repeat N] [--threads N] [--impl list,matrix,csr]
+//                      [--methods NAME,...] [--cubic-limit V] <graph files...>
+// Each run writes its result block to a discarding stream and the best of
+// N runs is reported. Prints CSV by default, one JSON object per line with
+// --json: graph,vertices,edges,impl,method,seconds,ok. All-pairs methods
+// (FLOYD, JOHNSON, CENTRALITY) are skipped above --cubic-limit vertices.
+#include "../GraphMethod.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <sstream>
+
+// Stream buffer that drops everything, so printing is timed but not kept
+class NullBuffer : public streambuf{
+protected:
+	int overflow(int c) { return c; }
+	streamsize xsputn(const char*, streamsize n) { return n; }
+};
+
+struct Options{
+	bool json;
+	int repeat;
+	int threads;
+	int cubicLimit;
+	string impls;
+	string methods;
+};
+
+// Comma-separated list membership; an empty list matches everything
+static bool listed(const string& list, const string& name)
+{
+	if (list.empty()) return true;
+	string padded = "," + list + ",";
+	return padded.find("," + name + ",") != string::npos;
+}
+
+static void report(const Options& opt, const char* file, Graph* graph, long long edges,
+	const char* impl, const string& method, double seconds, bool ok)
+{
+	if (opt.json) {
+		printf("{\"graph\":\"%s\",\"vertices\":%d,\"edges\":%lld,\"impl\":\"%s\",\"method\":\"%s\","
+			"\"seconds\":%.6f,\"ok\":%s}\n", file, graph->getSize(), edges, impl, method.c_str(),
+			seconds, ok ? "true" : "false");
+	} else {
+		printf("%s,%d,%lld,%s,%s,%.6f,%d\n", file, graph->getSize(), edges, impl, method.c_str(),
+			seconds, ok ? 1 : 0);
+	}
+	fflush(stdout);
+}
+
+// Best of opt.repeat runs of one entry point
+template <typename F>
+static void timeMethod(const Options& opt, const char* file, Graph* graph, long long edges,
+	const char* impl, const string& method, F run)
+{
+	string family = method.substr(0, method.find(' '));
+	if (!listed(opt.methods, family)) return;
+	
+	NullBuffer discard;
+	ostream out(&discard);
+	double best = 0;
+	bool ok = true;
+	for (int r = 0; r < opt.repeat; r++) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		ok = run(&out);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		if (r == 0 || seconds < best) best = seconds;
+	}
+	report(opt, file, graph, edges, impl, method, best, ok);
+}
+
+static void benchGraph(const Options& opt, const char* file, Graph* graph, long long edges,
+	const char* impl, ThreadPool* pool)
+{
+	int size = graph->getSize();
+	int last = size - 1;
+	bool cubic = (size <= opt.cubicLimit);
+	const char options[2] = {'O', 'X'};
+	
+	// Sources for the batch run: up to 64 spread over the vertices
+	vector<int> sources;
+	for (int v = 0; v < size && sources.size() < 64; v += max(1, size / 64)) sources.push_back(v);
+	QueryIndex index;
+	buildQueryIndex(graph, 0, &index);
+	
+	for (int o = 0; o < 2; o++) {
+		char option = options[o];
+		string x = string(" ") + option;
+		timeMethod(opt, file, graph, edges, impl, "BFS" + x + " HYBRID", [&](ostream* out) {
+			return BFS(graph, option, 0, out, 'H', pool); });
+		timeMethod(opt, file, graph, edges, impl, "BFS" + x + " QUEUE", [&](ostream* out) {
+			return BFS(graph, option, 0, out, 'Q', pool); });
+		timeMethod(opt, file, graph, edges, impl, "BFSLEVEL" + x, [&](ostream* out) {
+			return BFSLevel(graph, option, 0, out, pool); });
+		timeMethod(opt, file, graph, edges, impl, "DFS" + x, [&](ostream* out) {
+			return DFS(graph, option, 0, out); });
+		timeMethod(opt, file, graph, edges, impl, "DIJKSTRA" + x + " AUTO", [&](ostream* out) {
+			return Dijkstra(graph, option, 0, out, 'A'); });
+		timeMethod(opt, file, graph, edges, impl, "DIJKSTRA" + x + " INDEXED", [&](ostream* out) {
+			return Dijkstra(graph, option, 0, out, 'I'); });
+		timeMethod(opt, file, graph, edges, impl, "DIJKSTRA" + x + " BINARY", [&](ostream* out) {
+			return Dijkstra(graph, option, 0, out, 'B'); });
+		timeMethod(opt, file, graph, edges, impl, "DIJKSTRA_BATCH" + x, [&](ostream* out) {
+			return DijkstraBatch(graph, option, sources, out, 'A', pool); });
+		timeMethod(opt, file, graph, edges, impl, "BELLMANFORD" + x + " PASSES", [&](ostream* out) {
+			return Bellmanford(graph, option, 0, last, out, 'E', pool); });
+		timeMethod(opt, file, graph, edges, impl, "BELLMANFORD" + x + " SPFA", [&](ostream* out) {
+			return Bellmanford(graph, option, 0, last, out, 'S', pool); });
+		timeMethod(opt, file, graph, edges, impl, "BELLMANFORD" + x + " PARALLEL", [&](ostream* out) {
+			return Bellmanford(graph, option, 0, last, out, 'P', pool); });
+		timeMethod(opt, file, graph, edges, impl, "QUERY" + x, [&](ostream* out) {
+			return Query(graph, option, 0, last, &index, out); });
+		if (cubic) {
+			timeMethod(opt, file, graph, edges, impl, "FLOYD" + x, [&](ostream* out) {
+				return FLOYD(graph, option, out, pool); });
+			timeMethod(opt, file, graph, edges, impl, "JOHNSON" + x, [&](ostream* out) {
+				return Johnson(graph, option, out, pool); });
+		}
+	}
+	timeMethod(opt, file, graph, edges, impl, "KRUSKAL", [&](ostream* out) {
+		return Kruskal(graph, out, 'K', pool); });
+	timeMethod(opt, file, graph, edges, impl, "KRUSKAL BORUVKA", [&](ostream* out) {
+		return Kruskal(graph, out, 'B', pool); });
+	if (cubic) {
+		timeMethod(opt, file, graph, edges, impl, "CENTRALITY", [&](ostream* out) {
+			return Centrality(graph, out, pool); });
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	opt.json = false;
+	opt.repeat = 3;
+	opt.threads = max(1, (int)thread::hardware_concurrency());
+	opt.cubicLimit = 2000;
+	
+	int arg = 1;
+	for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+		string flag = argv[arg];
+		if (flag == "--json") {
+			opt.json = true;
+		} else if (arg + 1 < argc && flag == "--repeat") {
+			opt.repeat = max(1, atoi(argv[++arg]));
+		} else if (arg + 1 < argc && flag == "--threads") {
+			opt.threads = max(1, atoi(argv[++arg]));
+		} else if (arg + 1 < argc && flag == "--cubic-limit") {
+			opt.cubicLimit = atoi(argv[++arg]);
+		} else if (arg + 1 < argc && flag == "--impl") {
+			opt.impls = argv[++arg];
+		} else if (arg + 1 < argc && flag == "--methods") {
+			opt.methods = argv[++arg];
+		} else {
+			fprintf(stderr, "unknown option %s\n", argv[arg]);
+			return 1;
+		}
+	}
+	if (arg == argc) {
+		fprintf(stderr, "usage: %s [--json] [--repeat N] [--threads N] [--impl list,matrix,csr] "
+			"[--methods NAME,...] [--cubic-limit V] <graph files...>\n", argv[0]);
+		return 1;
+	}
+	
+	ThreadPool pool(opt.threads);
+	if (!opt.json) printf("graph,vertices,edges,impl,method,seconds,ok\n");
+	for (; arg < argc; arg++) {
+		const char* file = argv[arg];
+		GraphFile input;
+		EdgeList edges;
+		if (!input.open(file) || !input.parse(&edges)) {
+			fprintf(stderr, "cannot load %s\n", file);
+			continue;
+		}
+		
+		// The flat copy the Manager runs on, plus the two classic layouts
+		// built the same way Manager::getGraph() builds them for PRINT
+		CsrGraph csr(edges);
+		long long count = csr.getEdgeCount();
+		if (listed(opt.impls, "csr")) {
+			benchGraph(opt, file, &csr, count, "csr", &pool);
+		}
+		if (listed(opt.impls, "list")) {
+			ListGraph list(true, edges.size);
+			for (size_t e = 0; e < edges.from.size(); e++)
+				list.insertEdge(edges.from[e], edges.to[e], edges.weight[e]);
+			benchGraph(opt, file, &list, count, "list", &pool);
+		}
+		if (listed(opt.impls, "matrix")) {
+			MatrixGraph matrix(true, edges.size);
+			for (size_t e = 0; e < edges.from.size(); e++)
+				matrix.insertEdge(edges.from[e], edges.to[e], edges.weight[e]);
+			benchGraph(opt, file, &matrix, count, "matrix", &pool);
+		}
+	}
+	return 0;
+}
\ No newline at end of file
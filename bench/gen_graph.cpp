@@ -0,0 +1,129 @@
+// Reproducible synthetic graphs in the graph_L / graph_M formats.
+// Usage: gen_graph <er|grid|powerlaw> <L|M> <vertices> <edges> <min weight>
+//                  <max weight> <negative fraction> <seed>
+// Weights are drawn from [min, max] (at least 1, since 0 means "no edge"
+// in the M format); each edge is then negated with the given probability.
+// grid ignores the edge count and links each cell of a square grid to
+// its four neighbors. The random numbers come from mt19937 alone, without
+// the <random> distributions, so a seed gives the same file everywhere.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+using namespace std;
+
+static mt19937 rng;
+
+// Uniform integer in [lo, hi]
+static int uniformInt(int lo, int hi)
+{
+	return lo + (int)(rng() % (unsigned)(hi - lo + 1));
+}
+
+// Uniform double in [0, 1)
+static double uniformReal()
+{
+	return (rng() >> 5) * (1.0 / 134217728.0);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 9) {
+		fprintf(stderr, "usage: %s <er|grid|powerlaw> <L|M> <vertices> <edges> <min weight> "
+			"<max weight> <negative fraction> <seed>\n", argv[0]);
+		return 1;
+	}
+	const char* kind = argv[1];
+	char format = argv[2][0];
+	int n = atoi(argv[3]);
+	long long m = atoll(argv[4]);
+	int wmin = max(1, atoi(argv[5]));
+	int wmax = max(wmin, atoi(argv[6]));
+	double negative = atof(argv[7]);
+	rng.seed((unsigned)atoi(argv[8]));
+	if (n <= 0 || (format != 'L' && format != 'M')) {
+		fprintf(stderr, "need a positive vertex count and format L or M\n");
+		return 1;
+	}
+	
+	// Adjacency as (to, weight) per vertex; a repeated pair keeps the last
+	vector<vector<pair<int, int>>> adj(n);
+	auto addEdge = [&](int from, int to) {
+		int w = uniformInt(wmin, wmax);
+		if (uniformReal() < negative) w = -w;
+		adj[from].push_back(make_pair(to, w));
+	};
+	
+	if (strcmp(kind, "er") == 0) {
+		// Erdos-Renyi G(n, m): m endpoints drawn uniformly, no self-loops
+		for (long long e = 0; e < m && n > 1; e++) {
+			int from = uniformInt(0, n - 1);
+			int to = uniformInt(0, n - 2);
+			if (to >= from) to++;
+			addEdge(from, to);
+		}
+	} else if (strcmp(kind, "grid") == 0) {
+		// Square grid with edges both ways between neighboring cells
+		int side = (int)sqrt((double)n);
+		n = side * side;
+		adj.resize(n);
+		for (int v = 0; v < n; v++) {
+			int x = v % side, y = v / side;
+			if (x > 0) addEdge(v, v - 1);
+			if (x + 1 < side) addEdge(v, v + 1);
+			if (y > 0) addEdge(v, v - side);
+			if (y + 1 < side) addEdge(v, v + side);
+		}
+	} else if (strcmp(kind, "powerlaw") == 0) {
+		// Chung-Lu with degree exponent 2.5: vertex i is an endpoint with
+		// probability proportional to (i + 1)^(-1 / 1.5)
+		vector<double> cumulative(n);
+		double total = 0;
+		for (int v = 0; v < n; v++) {
+			total += pow(v + 1.0, -1.0 / 1.5);
+			cumulative[v] = total;
+		}
+		auto pick = [&]() {
+			double r = uniformReal() * total;
+			int v = (int)(upper_bound(cumulative.begin(), cumulative.end(), r) - cumulative.begin());
+			return min(v, n - 1);
+		};
+		for (long long e = 0; e < m && n > 1; e++) {
+			int from = pick(), to = pick();
+			if (from != to) addEdge(from, to);
+		}
+	} else {
+		fprintf(stderr, "unknown graph kind %s\n", kind);
+		return 1;
+	}
+	
+	printf("%c\n%d\n", format, n);
+	if (format == 'L') {
+		// Vertex line, then its "to weight" pairs on the next line
+		for (int v = 0; v < n; v++) {
+			printf("%d\n", v);
+			for (size_t k = 0; k < adj[v].size(); k++) {
+				printf(k ? " %d %d" : "%d %d", adj[v][k].first, adj[v][k].second);
+			}
+			printf("\n");
+		}
+	} else {
+		// Dense rows, 0 where there is no edge
+		vector<int> row(n);
+		for (int v = 0; v < n; v++) {
+			fill(row.begin(), row.end(), 0);
+			for (size_t k = 0; k < adj[v].size(); k++) {
+				row[adj[v][k].first] = adj[v][k].second;
+			}
+			for (int u = 0; u < n; u++) {
+				printf(u ? " %d" : "%d", row[u]);
+			}
+			printf("\n");
+		}
+	}
+	return 0;
+}
\ No newline at end of file
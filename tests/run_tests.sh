@@ -0,0 +1,28 @@
+#!/bin/sh
+# Regression cases: each directory under tests/ holds a command.txt and
+# the log.txt it must produce (expected.txt). A case runs in a scratch
+# directory next to copies of the sample graph files and of any other
+# files the case brings (its own graphs), and fails if the program exits
+# abnormally or the log differs.
+cd "$(dirname "$0")/.." || exit 1
+root=$(pwd)
+failed=0
+for dir in tests/*/; do
+	name=$(basename "$dir")
+	work=$(mktemp -d)
+	cp graph_L.txt graph_M.txt "$work"/
+	for file in "$dir"*; do
+		[ "$(basename "$file")" = expected.txt ] || cp "$file" "$work"/
+	done
+	(cd "$work" && "$root/run" 2>/dev/null)
+	rc=$?
+	if [ $rc -eq 0 ] && cmp -s "$work/log.txt" "$dir/expected.txt"; then
+		echo "PASS $name"
+	else
+		echo "FAIL $name (exit $rc)"
+		diff "$dir/expected.txt" "$work/log.txt" | head -20
+		failed=1
+	fi
+	rm -rf "$work"
+done
+exit $failed